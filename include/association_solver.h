@@ -0,0 +1,152 @@
+/**
+ * @desc:   assignment of detections to predictions maximizing the total IoU, which is what the Kuhn Munkres
+ *          assignment on the cost 1 - IoU computes. zero IoU pairs never change that total, so the problem
+ *          splits into the connected components of the overlap graph, and every component is solved by the
+ *          cheapest exact strategy for its shape:
+ *              GREEDY       one-to-many components, or greedy matchings certified optimal by a dual solution
+ *              BRUTE_FORCE  ambiguous components of at most 4 x 4
+ *              SPARSE       larger ambiguous components, Kuhn Munkres on the component only
+ *              DENSE        Kuhn Munkres on the whole matrix, when one dense component covers it
+ *          with a maximal dimension, a problem too large for it is matched greedily by decreasing IoU instead,
+ *          which bounds the Kuhn Munkres buffers (n x n) at the cost of optimality on those frames.
+ */
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "kuhn_munkres.h"
+
+namespace sort
+{
+    /**
+     * @brief strategies in increasing cost order
+     */
+    enum class SolverType : int
+    {
+        GREEDY,
+        BRUTE_FORCE,
+        SPARSE,
+        DENSE
+    };
+
+    constexpr int NUM_SOLVER_TYPES = 4;
+
+    struct AssociationStats
+    {
+        long numFrames = 0;
+        long numFrameStrategies[NUM_SOLVER_TYPES] = {};     // frames by their most expensive strategy
+        long numComponents[NUM_SOLVER_TYPES] = {};          // components solved by every strategy
+        long numCapped = 0;                                 // components above the maximal dimension, matched greedily
+        SolverType lastStrategy = SolverType::DENSE;        // most expensive strategy of the last frame
+    };
+
+    class AssociationSolver
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<AssociationSolver>;
+        using Pairs = std::vector<std::pair<int, int> >;   // first: row (detection), second: column (prediction)
+    private:
+        static constexpr int BRUTE_FORCE_SIZE = 4;  // maximal rows and columns of a brute-forced component
+        static constexpr float DENSE_DENSITY = 0.5f;// minimal density of a single component solved densely
+
+        bool adaptive = true;
+        int maxDimension = 0;                       // largest Kuhn Munkres problem, 0 if unbounded
+        AssociationStats stats;
+        kuhn_munkres::KuhnMunkres::Ptr km;
+
+        // scratch reused across frames
+        std::vector<int> parent;                    // union-find over rows [0, M) and columns [M, M + N)
+        std::vector<std::vector<int> > compRows, compCols;
+        std::vector<int> rowMatch, colMatch;
+
+    // methods
+    public:
+        AssociationSolver();
+        virtual ~AssociationSolver();
+        AssociationSolver(const AssociationSolver&) = delete;
+        AssociationSolver& operator=(const AssociationSolver&) = delete;
+
+        /**
+         * @brief assignment maximizing the total IoU
+         * @param iouMat IoU matrix, Mat(M, N)
+         * @param positiveOnly only pairs with a positive IoU are needed, otherwise the complete
+         *        assignment of the dense solver is returned
+         * @return assigned pairs ordered by row
+         */
+        Pairs solve(const cv::Mat& iouMat, bool positiveOnly=true);
+
+        /**
+         * @brief pick the strategy per component (default), or always solve densely
+         */
+        inline void setAdaptive(bool enable)
+        {
+            adaptive = enable;
+        }
+
+        inline bool isAdaptive() const
+        {
+            return adaptive;
+        }
+
+        /**
+         * @brief bound the size of the Kuhn Munkres problems, larger ones are matched greedily and counted
+         * @param dimension maximal rows and columns, 0 for no bound (default)
+         */
+        inline void setMaxDimension(int dimension)
+        {
+            maxDimension = dimension;
+        }
+
+        inline int getMaxDimension() const
+        {
+            return maxDimension;
+        }
+
+        /**
+         * @brief bytes held by the scratch buffers and the Kuhn Munkres solver, allocator overhead excluded
+         */
+        size_t memoryUsage() const;
+
+        inline const AssociationStats& getStats() const
+        {
+            return stats;
+        }
+
+        inline void resetStats()
+        {
+            stats = AssociationStats();
+        }
+
+    private:
+        /**
+         * @brief Kuhn Munkres on the cost 1 - IoU of the given rows and columns
+         */
+        void solveKuhnMunkres(const cv::Mat& iouMat, const std::vector<int>& rows, const std::vector<int>& cols);
+
+        /**
+         * @brief greedy matching by decreasing IoU
+         * @param keep keep the matching even if it is not certified
+         * @return true if it is certified optimal: every overlapping row (or every overlapping column)
+         *         gets its best pair, which makes the matched IoUs a feasible dual solution
+         */
+        bool solveGreedy(const cv::Mat& iouMat, const std::vector<int>& rows, const std::vector<int>& cols, bool keep=false);
+
+        /**
+         * @brief true if Kuhn Munkres may run on rows x cols
+         */
+        inline bool fits(size_t numRows, size_t numCols) const
+        {
+            return maxDimension <= 0 || std::max(numRows, numCols) <= size_t(maxDimension);
+        }
+
+        /**
+         * @brief every injective mapping of the smaller side into the larger one
+         */
+        void solveBruteForce(const cv::Mat& iouMat, const std::vector<int>& rows, const std::vector<int>& cols);
+
+        int findRoot(int v);
+    };
+}
@@ -0,0 +1,82 @@
+/**
+ * @desc:   blocking FIFO queue with a fixed capacity, used to connect pipeline stages.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace sort
+{
+    template<typename _Tp>
+    class BoundedQueue
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<BoundedQueue<_Tp> >;
+    private:
+        size_t capacity;
+        bool closed = false;
+        std::deque<_Tp> items;
+        std::mutex mtx;
+        std::condition_variable notFull, notEmpty;
+
+    // methods
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1)
+        {
+        }
+
+        virtual ~BoundedQueue()
+        {
+        }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        /**
+         * @brief append an item, blocks while the queue is full
+         * @param item item to append
+         * @return false if the queue has been closed, the item is dropped then
+         */
+        bool push(_Tp item)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+            if (closed) return false;
+            items.push_back(std::move(item));
+            notEmpty.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief take the oldest item, blocks while the queue is empty
+         * @param item output item
+         * @return false if the queue has been closed and drained
+         */
+        bool pop(_Tp& item)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+            if (items.empty()) return false;
+            item = std::move(items.front());
+            items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief reject further pushes and wake up every waiting thread,
+         *        items already queued can still be popped
+         */
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+            notFull.notify_all();
+            notEmpty.notify_all();
+        }
+    };
+}
@@ -0,0 +1,93 @@
+/**
+ * @desc:   delta encoding of Sort output for constrained links. only tracks that appeared or moved
+ *          beyond position/size tolerances since they were last sent are emitted, plus the ids of
+ *          tracks no longer reported. a DeltaDecoder applying every delta holds the same set of
+ *          tracks as the full output, each box within the tolerances of the current one.
+ */
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace sort
+{
+    struct TrackDelta
+    {
+        cv::Mat updated;            // Mat(K, 9) rows of Sort::update output, new or changed tracks
+        std::vector<int> removed;   // tracker ids not reported anymore, ascending
+    };
+
+    class DeltaEncoder
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<DeltaEncoder>;
+    private:
+        float posTol;       // pixels, xc and yc
+        float sizeTol;      // pixels, w and h
+        std::unordered_map<int, cv::Vec4f> sent;    // tracker id -> box last sent
+
+    // methods
+    public:
+        /**
+         * @param posTol position tolerance in pixels, a track is resent when xc or yc moved more
+         * @param sizeTol size tolerance in pixels, a track is resent when w or h changed more
+         */
+        DeltaEncoder(float posTol=1.0f, float sizeTol=1.0f);
+        virtual ~DeltaEncoder();
+        DeltaEncoder(const DeltaEncoder&) = delete;
+        DeltaEncoder& operator=(const DeltaEncoder&) = delete;
+
+        /**
+         * @brief delta of a frame against what has been sent so far
+         * @param bboxesPost output of Sort::update, Mat(N, 9)
+         * @return tracks to send and ids to remove
+         */
+        TrackDelta encode(const cv::Mat &bboxesPost);
+
+        /**
+         * @brief forget what has been sent, the next delta carries every track
+         */
+        void reset();
+
+        /**
+         * @brief approximate bytes held by the encoder, allocator overhead excluded
+         */
+        inline size_t memoryUsage() const
+        {
+            // a node holds the pair and the next pointer, plus one bucket pointer per bucket
+            return sizeof(*this) + sent.size() * (sizeof(std::pair<const int, cv::Vec4f>) + sizeof(void*)) +
+                   sent.bucket_count() * sizeof(void*);
+        }
+    };
+
+    class DeltaDecoder
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<DeltaDecoder>;
+    private:
+        std::unordered_map<int, cv::Mat> tracks;    // tracker id -> Mat(1, 9)
+
+    // methods
+    public:
+        DeltaDecoder();
+        virtual ~DeltaDecoder();
+        DeltaDecoder(const DeltaDecoder&) = delete;
+        DeltaDecoder& operator=(const DeltaDecoder&) = delete;
+
+        /**
+         * @brief apply the delta of the next frame
+         * @param delta delta produced by DeltaEncoder::encode
+         */
+        void apply(const TrackDelta &delta);
+
+        /**
+         * @brief current tracks, ordered by tracker id
+         * @return Mat(N, 9) in the format of Sort::update
+         */
+        cv::Mat getTracks() const;
+    };
+}
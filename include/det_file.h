@@ -0,0 +1,152 @@
+/**
+ * @desc:   detection sequence I/O, MOT text files and the binary columnar format.
+ *          binary layout (little endian, every section 64 bytes aligned):
+ *              DetFileHeader
+ *              DetFileFrame[numFrames]     frame index table, frame k is firstFrame + k
+ *              float   xc[numDets], yc[numDets], w[numDets], h[numDets], score[numDets]
+ *              int32   classId[numDets], objId[numDets]
+ *          the detections of a frame are the rows [first, first + count) of every column.
+ */
+#pragma once
+
+#include <opencv2/core/core.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+namespace sort
+{
+    constexpr char DET_FILE_MAGIC[8] = {'S', 'O', 'R', 'T', 'D', 'E', 'T', '\0'};
+    constexpr uint32_t DET_FILE_VERSION = 1;
+    constexpr int DET_FILE_NUM_COLS = 7;   // xc, yc, w, h, score, class_id, obj_id
+
+    struct DetFileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numFrames;
+        uint64_t numDets;
+        int32_t firstFrame;
+        uint32_t reserved;
+        uint64_t indexOffset;                       // offset of DetFileFrame[numFrames]
+        uint64_t colOffsets[DET_FILE_NUM_COLS];     // offset of each column
+    };
+
+    struct DetFileFrame
+    {
+        uint64_t first;     // first row of the frame
+        uint32_t count;     // number of rows
+        uint32_t reserved;
+    };
+
+    /**
+     * @brief zero-copy view on the detections of one frame, valid while the reader lives
+     */
+    struct DetFrameView
+    {
+        int frameId = 0;
+        int count = 0;
+        const float *xc = nullptr, *yc = nullptr, *w = nullptr, *h = nullptr, *score = nullptr;
+        const int32_t *classId = nullptr, *objId = nullptr;
+    };
+
+    /**
+     * @brief detections of a whole sequence in memory
+     */
+    struct DetSequence
+    {
+        int firstFrame = 1;
+        std::vector<cv::Mat> dets;          // per frame, Mat(M, 6) [xc, yc, w, h, score, class_id]
+        std::vector<std::vector<int> > ids; // per frame, object id of each row, -1 if unknown
+    };
+
+    class DetFileReader
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<DetFileReader>;
+    private:
+        MappedFile file;
+        const DetFileHeader* header = nullptr;
+        const DetFileFrame* index = nullptr;
+
+    // methods
+    public:
+        /**
+         * @brief map a binary detection file, throws std::runtime_error if it is not valid
+         * @param path binary detection file
+         */
+        explicit DetFileReader(const std::string& path);
+
+        virtual ~DetFileReader();
+        DetFileReader(const DetFileReader&) = delete;
+        DetFileReader& operator=(const DetFileReader&) = delete;
+
+        inline int getNumFrames() const
+        {
+            return header->numFrames;
+        }
+
+        inline int getFirstFrame() const
+        {
+            return header->firstFrame;
+        }
+
+        inline size_t getNumDets() const
+        {
+            return header->numDets;
+        }
+
+        /**
+         * @brief columnar view of frame k without copying
+         * @param k frame index in [0, getNumFrames())
+         * @return view on the mapped columns
+         */
+        DetFrameView getFrame(int k) const;
+
+        /**
+         * @brief detections of frame k in the layout taken by Sort::update
+         * @param k frame index in [0, getNumFrames())
+         * @return Mat(M, 6) [xc, yc, w, h, score, class_id]
+         */
+        cv::Mat getDetections(int k) const;
+    };
+
+    /**
+     * @brief check whether a file is in the binary detection format
+     * @param path file path
+     * @return true if the file starts with DET_FILE_MAGIC
+     */
+    bool isDetFile(const std::string& path);
+
+    /**
+     * @brief parse a MOT text file (det.txt or gt.txt),
+     *        each line is [frame, id, x0, y0, w, h, score, class, ...], class_id is the class column
+     *        when it is positive (MOT16+ ground truth), 0 otherwise
+     * @param path text file
+     * @return detections per frame, starting at frame 1
+     */
+    DetSequence readMotText(const std::string& path);
+
+    /**
+     * @brief load a sequence stored in the binary format
+     * @param path binary detection file
+     * @return detections per frame
+     */
+    DetSequence readDetFile(const std::string& path);
+
+    /**
+     * @brief load a sequence in either format, the binary one is detected by its magic
+     * @param path text or binary detection file
+     * @return detections per frame
+     */
+    DetSequence readDetections(const std::string& path);
+
+    /**
+     * @brief store a sequence in the binary format, throws std::runtime_error on failure
+     * @param path output file
+     * @param seq detections per frame
+     */
+    void writeDetFile(const std::string& path, const DetSequence& seq);
+}
@@ -1,66 +1,202 @@
 /**
- * @desc:   kalmanfilter for boundary box tracking.
- *          opencv kalmanfilter documents:
+ * @desc:   kalmanfilter for boundary box tracking, templated on a motion model (see motion_models.h).
+ *          the state and covariance are fixed-size arrays and the filter loops run over the model's
+ *          constexpr matrices, so every instantiation is unrolled for its model. the same equations as
+ *          cv::KalmanFilter, which ReferenceCheck keeps as the reference:
  *              https://docs.opencv.org/4.x/dd/d6a/classcv_1_1KalmanFilter.html
- * 
+ *
  * @author: lst
  * @date:   12/10/2021
  */
 #pragma once
 
-#include <opencv2/video/tracking.hpp>
+#include <opencv2/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <assert.h>
 #include <math.h>
+#include <array>
 #include <memory>
-
-#define KF_DIM_X 7      // xc, yc, s, r, dxc/dt, dyc/dt, ds/dt
-#define KF_DIM_Z 4      // xc, yc, s, r
+#include <atomic>
+#include <cstdint>
+#include "motion_models.h"
 
 namespace sort
 {
-    class KalmanBoxTracker
+    /**
+     * @brief plain copy of a tracker, also the record layout of Sort snapshots
+     */
+    template<class Model>
+    struct KalmanBoxTrackerStateT
+    {
+        int32_t id;
+        int32_t timeSinceUpdate;
+        int32_t hitStreak;
+        int32_t hasPost;    // corrected at least once, getState() is valid
+        int32_t confirmed;  // reported as confirmed once
+        float statePost[Model::DIM_X];
+        float errorCovPost[Model::DIM_X * Model::DIM_X];
+    };
+
+    /**
+     * @brief tracker id sequence, shared by the trackers of every motion model
+     */
+    class TrackerIds
     {
     // variables
+    protected:
+        static std::atomic<int> count;     // shared by all Sort instances, ids stay unique across threads
+
+    // methods
     public:
-        using Ptr = std::shared_ptr<KalmanBoxTracker>;
+        static inline int getFilterCount()
+        {
+            return TrackerIds::count;
+        }
+
+        /**
+         * @brief reserve an id of the tracker id sequence without creating a tracker
+         * @return reserved id
+         */
+        static inline int takeFilterId()
+        {
+            return TrackerIds::count++;
+        }
+
+        /**
+         * @brief make sure ids below minCount are never handed out again
+         * @param minCount minimal value of the id sequence
+         */
+        static inline void reserveFilterIds(int minCount)
+        {
+            int current = TrackerIds::count;
+            while (current < minCount && !TrackerIds::count.compare_exchange_weak(current, minCount))
+                ;
+        }
+
+        /**
+         * @brief restart the id sequence, e.g. to replay a trace with the recorded ids.
+         *        ids of trackers alive in other Sort instances may be handed out again
+         * @param value next id
+         */
+        static inline void resetFilterIds(int value=0)
+        {
+            TrackerIds::count = value;
+        }
+    };
+
+    template<class Model>
+    class KalmanBoxTrackerT : public TrackerIds
+    {
+        static_assert(Model::DIM_Z == 4, "the measurement is [xc, yc, s, r]");
+        static_assert(Model::DIM_X > Model::DIM_Z, "the state starts with the measurement");
+
+    // variables
+    public:
+        using Ptr = std::shared_ptr<KalmanBoxTrackerT<Model> >;
+        using State = KalmanBoxTrackerStateT<Model>;
+        static constexpr int DIM_X = Model::DIM_X;
+        static constexpr int DIM_Z = Model::DIM_Z;
     private:
-        static int count;
         int id;
         int timeSinceUpdate = 0;
         int hitStreak = 0;
-        std::shared_ptr<cv::KalmanFilter> kf = nullptr;
-        cv::Mat xPost;
-    
+        bool confirmed = false;     // reported as confirmed once, kept when the hit streak restarts
+        bool hasPost = false;       // corrected at least once
+        std::array<float, DIM_X> x;             // corrected state, the prediction after predict
+        std::array<float, DIM_X * DIM_X> P;     // error covariance, row major
+
     // methods
     public:
         /**
          * @brief Kalman filter for bbox tracking
          * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
+         * @param id tracker id, the next id of the shared sequence if negative
+         */
+        explicit KalmanBoxTrackerT(const cv::Mat &bbox, int id=-1);
+
+        /**
+         * @brief recreate a tracker from a copy of its state, keeping its id
+         * @param state tracker state
+         */
+        explicit KalmanBoxTrackerT(const State &state);
+
+        /**
+         * @brief unset tracker, e.g. built in bulk by TrackerPoolT::reserve. reset or importState before use,
+         *        it takes no id
          */
-        explicit KalmanBoxTracker(const cv::Mat &bbox);
+        KalmanBoxTrackerT();
 
-        virtual ~KalmanBoxTracker();
-        KalmanBoxTracker(const KalmanBoxTracker&) = delete;
-        void operator=(const KalmanBoxTracker&) = delete;
+        virtual ~KalmanBoxTrackerT();
+        KalmanBoxTrackerT(const KalmanBoxTrackerT&) = delete;
+        void operator=(const KalmanBoxTrackerT&) = delete;
 
         /**
-         * @brief updates the state vector with observed bbox. 
+         * @brief restart the tracker on a new object in place: takes a new id and
+         *        re-initializes the filter state
+         * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
+         * @param id tracker id, the next id of the shared sequence if negative
+         */
+        void reset(const cv::Mat &bbox, int id=-1);
+
+        /**
+         * @brief copy the tracker state out
+         * @param state output state
+         */
+        void exportState(State &state) const;
+
+        /**
+         * @brief overwrite the tracker with a copied state in place, including its id
+         * @param state tracker state
+         */
+        void importState(const State &state);
+
+        /**
+         * @brief updates the state vector with observed bbox: the Kalman correction on fixed-size arrays,
+         *        with the gain solved by a Cholesky factorization of the 4 x 4 innovation covariance
          * @param bbox  boundary box, Mat(1, 4+) [xc, yc, w, h, ...]
          * @return corrected bounding box estimate, Mat(1, 4)
          */
         cv::Mat update(const cv::Mat &bbox);
 
         /**
-         * @brief advances the state vector and returns the predicted bounding box estimate. 
+         * @brief advances the state vector and returns the predicted bounding box estimate.
+         *        same operations as predictBatch on a single tracker
          * @return predicted bounding box, Mat(1, 4)
          */
         cv::Mat predict();
 
-        static inline int getFilterCount()
-        {
-            return KalmanBoxTracker::count;
-        }
+        /**
+         * @brief copy the corrected state out for a batched predict, structure of arrays layout
+         * @param x output, element k of the state goes to x[k * stride]
+         * @param errorCov output, element (i, j) of the covariance goes to errorCov[(i * DIM_X + j) * stride]
+         * @param stride distance between two elements of one tracker
+         */
+        void gatherPost(float* x, float* errorCov, size_t stride) const;
+
+        /**
+         * @brief finish a batched predict, same effect as predict() given the output of predictBatch
+         * @param x predicted state, element k at x[k * stride]
+         * @param errorCov predicted covariance, element (i, j) at errorCov[(i * DIM_X + j) * stride]
+         * @param stride distance between two elements of one tracker
+         * @return predicted bounding box, Mat(1, 4)
+         */
+        cv::Mat scatterPrior(const float* x, const float* errorCov, size_t stride);
+
+        /**
+         * @brief predict step of many trackers at once on states gathered by gatherPost,
+         *        x = F*x and P = F*P*Ft + Q in place, the operations of predict() in the same order
+         * @param x states, element k of tracker t at x[k * stride + t]
+         * @param errorCov covariances, element (i, j) of tracker t at errorCov[(i * DIM_X + j) * stride + t]
+         * @param n number of trackers
+         * @param stride distance between two elements of one tracker, >= n
+         */
+        static void predictBatch(float* x, float* errorCov, size_t n, size_t stride);
+
+        /**
+         * @brief approximate bytes held by the tracker: the object, its state arrays included, and its
+         *        shared_ptr control block. allocator overhead is excluded
+         */
+        size_t memoryUsage() const;
 
         inline int getFilterId()
         {
@@ -77,43 +213,54 @@ namespace sort
             return hitStreak;
         }
 
+        /**
+         * @brief corrected state, Mat(DIM_X, 1), empty before the first update
+         */
         inline cv::Mat getState()
         {
-            return xPost.clone();
+            return hasPost ? cv::Mat(DIM_X, 1, CV_32F, x.data()).clone() : cv::Mat();
+        }
+
+        inline bool isConfirmed() const
+        {
+            return confirmed;
+        }
+
+        inline void setConfirmed()
+        {
+            confirmed = true;
         }
 
     private:
         /**
          * @brief convert boundary box to measurement.
          * @param bbox boundary box (1, 4+) [x center, y center, width, height, ...]
-         * @return measurement vector (4, 1) [x center; y center; scale/area; aspect ratio]
+         * @param z output, DIM_Z values [x center, y center, scale/area, aspect ratio]
          */
-        static inline cv::Mat convertBBoxToZ(const cv::Mat &bbox)
+        static inline void convertBBoxToZ(const cv::Mat &bbox, float* z)
         {
             assert(bbox.rows == 1 && bbox.cols >= 4);
-            float x = bbox.at<float>(0, 0);
-            float y = bbox.at<float>(0, 1);
-            float s = bbox.at<float>(0, 2) * bbox.at<float>(0, 3);
-            float r = bbox.at<float>(0, 2) / bbox.at<float>(0, 3);
-
-            return (cv::Mat_<float>(KF_DIM_Z, 1) << x, y, s, r);
+            z[0] = bbox.at<float>(0, 0);
+            z[1] = bbox.at<float>(0, 1);
+            z[2] = bbox.at<float>(0, 2) * bbox.at<float>(0, 3);
+            z[3] = bbox.at<float>(0, 2) / bbox.at<float>(0, 3);
         }
 
         /**
          * @brief convert state vector to boundary box.
-         * @param state state vector (7, 1) (x center; y center; scale/area; aspect ratio; ...)
+         * @param state state vector, DIM_X values [x center, y center, scale/area, aspect ratio, ...]
          * @return boundary box (1, 4) [x center, y center, width, height]
          */
-        static inline cv::Mat convertXToBBox(const cv::Mat &state)
+        static inline cv::Mat convertXToBBox(const float* state)
         {
-            assert(state.rows == KF_DIM_X && state.cols == 1);
-            float x = state.at<float>(0, 0);
-            float y = state.at<float>(1, 0);
-            float w = sqrt(state.at<float>(2, 0) * state.at<float>(3, 0));
-            float h = state.at<float>(2, 0) / w;
+            float w = sqrt(state[2] * state[3]);
+            float h = state[2] / w;
 
-            return (cv::Mat_<float>(1, 4) << x, y, w, h);
+            return (cv::Mat_<float>(1, 4) << state[0], state[1], w, h);
         }
     };
-}
 
+    // the model of the SORT paper, used by the rest of the library
+    using KalmanBoxTrackerState = KalmanBoxTrackerStateT<ConstantVelocityModel>;
+    using KalmanBoxTracker = KalmanBoxTrackerT<ConstantVelocityModel>;
+}
@@ -11,6 +11,7 @@
 
 #include <vector>
 #include <memory>
+#include <cstddef>
 #include <functional>
 
 namespace kuhn_munkres {
@@ -58,6 +59,13 @@ public:
      */
     vector<pair<int, int> > compute(const Vec2f& costMatrix);
 
+    /**
+     * @brief Bytes held by the object and the buffers of the last `compute()`:
+     *        the padded cost matrix and the marks (n x n each) and the path (2n + 1).
+     * @return bytes, allocator overhead excluded
+     */
+    size_t memoryUsage() const;
+
     /**
      * @brief Create a cost matrix from a profit matrix by calling `inversion_function()`
      *        to invert each value. The inversion function must take one numeric argument
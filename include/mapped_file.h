@@ -0,0 +1,44 @@
+/**
+ * @desc:   read-only memory mapped file.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace sort
+{
+    class MappedFile
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<MappedFile>;
+    private:
+        const uint8_t* ptr = nullptr;
+        size_t length = 0;
+
+    // methods
+    public:
+        /**
+         * @brief map the whole file read-only, throws std::runtime_error on failure
+         * @param path file path
+         */
+        explicit MappedFile(const std::string& path);
+
+        virtual ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        inline const uint8_t* data() const
+        {
+            return ptr;
+        }
+
+        inline size_t size() const
+        {
+            return length;
+        }
+    };
+}
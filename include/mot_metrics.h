@@ -0,0 +1,85 @@
+/**
+ * @desc:   MOT evaluation, CLEAR MOT (MOTA, ID switches, fragmentation) and identity (IDF1) metrics.
+ *          Bernardin K. "Evaluating multiple object tracking performance: the CLEAR MOT metrics", 2008.
+ *          Ristani E. "Performance measures and a data set for multi-target, multi-camera tracking", 2016.
+ */
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "kuhn_munkres.h"
+
+namespace sort
+{
+    struct MotMetrics
+    {
+        int numFrames = 0;
+        int numGt = 0;      // ground truth boxes
+        int numPred = 0;    // tracker boxes
+        int tp = 0, fp = 0, fn = 0;
+        int idsw = 0;       // identity switches
+        int frag = 0;       // fragmentations
+        int idtp = 0, idfp = 0, idfn = 0;
+
+        inline double mota() const
+        {
+            return numGt == 0 ? 0.0 : 1.0 - double(fn + fp + idsw) / numGt;
+        }
+
+        inline double idf1() const
+        {
+            return numGt + numPred == 0 ? 0.0 : 2.0 * idtp / (numGt + numPred);
+        }
+
+        MotMetrics& operator+=(const MotMetrics& other);
+    };
+
+    class MotAccumulator
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<MotAccumulator>;
+    private:
+        float iouThresh;
+        MotMetrics metrics;
+        std::map<int, int> lastMatch;                   // gt id -> tracker id of its last match
+        std::map<int, bool> tracked;                    // gt id -> matched when last seen
+        std::map<std::pair<int, int>, int> coCount;     // (gt id, tracker id) -> frames overlapping
+        kuhn_munkres::KuhnMunkres km;
+
+    // methods
+    public:
+        /**
+         * @param iouThresh minimal IoU for a tracker box to cover a ground truth box
+         */
+        explicit MotAccumulator(float iouThresh=0.5f);
+
+        virtual ~MotAccumulator();
+        MotAccumulator(const MotAccumulator&) = delete;
+        MotAccumulator& operator=(const MotAccumulator&) = delete;
+
+        /**
+         * @brief accumulate one frame
+         * @param gtBoxes ground truth boxes, Mat(G, 4+) [xc, yc, w, h, ...]
+         * @param gtIds ground truth ids, size G
+         * @param predBoxes tracker boxes, Mat(T, 4+) [xc, yc, w, h, ...]
+         * @param predIds tracker ids, size T
+         */
+        void update(const cv::Mat& gtBoxes, const std::vector<int>& gtIds,
+                    const cv::Mat& predBoxes, const std::vector<int>& predIds);
+
+        /**
+         * @brief metrics of all frames so far, the identity metrics are solved on each call
+         * @return accumulated metrics
+         */
+        MotMetrics getMetrics();
+
+    private:
+        /**
+         * @brief IoU of two boxes in float precision
+         */
+        static float iou(const float* a, const float* b);
+    };
+}
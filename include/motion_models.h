@@ -0,0 +1,157 @@
+/**
+ * @desc:   motion models of the bounding box Kalman filter, used as compile-time policies of
+ *          KalmanBoxTrackerT and SortT. a model supplies its dimensions and the F, H, Q, R and initial P
+ *          matrices as constexpr row-major arrays. the state starts with the measurement [xc, yc, s, r]
+ *          (center, area, aspect ratio), VX/VY index the center velocities reported by Sort and VS the
+ *          area velocity kept from driving the area negative (-1 if the model has none).
+ */
+#pragma once
+
+namespace sort
+{
+    /**
+     * @brief constant velocity in xc, yc, s and constant aspect ratio, the model of the SORT paper
+     */
+    struct ConstantVelocityModel
+    {
+        static constexpr int DIM_X = 7;     // xc, yc, s, r, dxc/dt, dyc/dt, ds/dt
+        static constexpr int DIM_Z = 4;     // xc, yc, s, r
+        static constexpr int VX = 4, VY = 5, VS = 6;
+
+        // state transition matrix (F), x(k) = F*x(k-1) + w(k)
+        static constexpr float F[DIM_X * DIM_X] = {
+            1, 0, 0, 0, 1, 0, 0,
+            0, 1, 0, 0, 0, 1, 0,
+            0, 0, 1, 0, 0, 0, 1,
+            0, 0, 0, 1, 0, 0, 0,
+            0, 0, 0, 0, 1, 0, 0,
+            0, 0, 0, 0, 0, 1, 0,
+            0, 0, 0, 0, 0, 0, 1};
+        // measurement matrix (H), z(k) = H*x(k) + v(k)
+        static constexpr float H[DIM_Z * DIM_X] = {
+            1, 0, 0, 0, 0, 0, 0,
+            0, 1, 0, 0, 0, 0, 0,
+            0, 0, 1, 0, 0, 0, 0,
+            0, 0, 0, 1, 0, 0, 0};
+        // process noise covariance matrix (Q)
+        static constexpr float Q[DIM_X * DIM_X] = {
+            1, 0, 0, 0, 0,    0,    0,
+            0, 1, 0, 0, 0,    0,    0,
+            0, 0, 1, 0, 0,    0,    0,
+            0, 0, 0, 1, 0,    0,    0,
+            0, 0, 0, 0, 1e-2, 0,    0,
+            0, 0, 0, 0, 0,    1e-2, 0,
+            0, 0, 0, 0, 0,    0,    1e-4};
+        // measurement noise covariance matrix (R)
+        static constexpr float R[DIM_Z * DIM_Z] = {
+            1, 0, 0,  0,
+            0, 1, 0,  0,
+            0, 0, 10, 0,
+            0, 0, 0,  10};
+        // initial error covariance (P), velocities are unknown
+        static constexpr float P0[DIM_X * DIM_X] = {
+            10, 0,  0,  0,  0,   0,   0,
+            0,  10, 0,  0,  0,   0,   0,
+            0,  0,  10, 0,  0,   0,   0,
+            0,  0,  0,  10, 0,   0,   0,
+            0,  0,  0,  0,  1e4, 0,   0,
+            0,  0,  0,  0,  0,   1e4, 0,
+            0,  0,  0,  0,  0,   0,   1e4};
+    };
+
+    /**
+     * @brief constant velocity of the center only, for static cameras where object sizes barely change
+     */
+    struct ReducedVelocityModel
+    {
+        static constexpr int DIM_X = 6;     // xc, yc, s, r, dxc/dt, dyc/dt
+        static constexpr int DIM_Z = 4;     // xc, yc, s, r
+        static constexpr int VX = 4, VY = 5, VS = -1;
+
+        static constexpr float F[DIM_X * DIM_X] = {
+            1, 0, 0, 0, 1, 0,
+            0, 1, 0, 0, 0, 1,
+            0, 0, 1, 0, 0, 0,
+            0, 0, 0, 1, 0, 0,
+            0, 0, 0, 0, 1, 0,
+            0, 0, 0, 0, 0, 1};
+        static constexpr float H[DIM_Z * DIM_X] = {
+            1, 0, 0, 0, 0, 0,
+            0, 1, 0, 0, 0, 0,
+            0, 0, 1, 0, 0, 0,
+            0, 0, 0, 1, 0, 0};
+        static constexpr float Q[DIM_X * DIM_X] = {
+            1, 0, 0, 0, 0,    0,
+            0, 1, 0, 0, 0,    0,
+            0, 0, 1, 0, 0,    0,
+            0, 0, 0, 1, 0,    0,
+            0, 0, 0, 0, 1e-2, 0,
+            0, 0, 0, 0, 0,    1e-2};
+        static constexpr float R[DIM_Z * DIM_Z] = {
+            1, 0, 0,  0,
+            0, 1, 0,  0,
+            0, 0, 10, 0,
+            0, 0, 0,  10};
+        static constexpr float P0[DIM_X * DIM_X] = {
+            10, 0,  0,  0,  0,   0,
+            0,  10, 0,  0,  0,   0,
+            0,  0,  10, 0,  0,   0,
+            0,  0,  0,  10, 0,   0,
+            0,  0,  0,  0,  1e4, 0,
+            0,  0,  0,  0,  0,   1e4};
+    };
+
+    /**
+     * @brief constant acceleration in xc, yc, s, for agile cameras such as drones
+     */
+    struct ConstantAccelerationModel
+    {
+        static constexpr int DIM_X = 10;    // xc, yc, s, r, dxc/dt, dyc/dt, ds/dt, d2xc/dt2, d2yc/dt2, d2s/dt2
+        static constexpr int DIM_Z = 4;     // xc, yc, s, r
+        static constexpr int VX = 4, VY = 5, VS = 6;
+
+        static constexpr float F[DIM_X * DIM_X] = {
+            1, 0, 0, 0, 1, 0, 0, 0.5, 0,   0,
+            0, 1, 0, 0, 0, 1, 0, 0,   0.5, 0,
+            0, 0, 1, 0, 0, 0, 1, 0,   0,   0.5,
+            0, 0, 0, 1, 0, 0, 0, 0,   0,   0,
+            0, 0, 0, 0, 1, 0, 0, 1,   0,   0,
+            0, 0, 0, 0, 0, 1, 0, 0,   1,   0,
+            0, 0, 0, 0, 0, 0, 1, 0,   0,   1,
+            0, 0, 0, 0, 0, 0, 0, 1,   0,   0,
+            0, 0, 0, 0, 0, 0, 0, 0,   1,   0,
+            0, 0, 0, 0, 0, 0, 0, 0,   0,   1};
+        static constexpr float H[DIM_Z * DIM_X] = {
+            1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 1, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 1, 0, 0, 0, 0, 0, 0};
+        static constexpr float Q[DIM_X * DIM_X] = {
+            1, 0, 0, 0, 0,    0,    0,    0,    0,    0,
+            0, 1, 0, 0, 0,    0,    0,    0,    0,    0,
+            0, 0, 1, 0, 0,    0,    0,    0,    0,    0,
+            0, 0, 0, 1, 0,    0,    0,    0,    0,    0,
+            0, 0, 0, 0, 1e-2, 0,    0,    0,    0,    0,
+            0, 0, 0, 0, 0,    1e-2, 0,    0,    0,    0,
+            0, 0, 0, 0, 0,    0,    1e-4, 0,    0,    0,
+            0, 0, 0, 0, 0,    0,    0,    1e-3, 0,    0,
+            0, 0, 0, 0, 0,    0,    0,    0,    1e-3, 0,
+            0, 0, 0, 0, 0,    0,    0,    0,    0,    1e-5};
+        static constexpr float R[DIM_Z * DIM_Z] = {
+            1, 0, 0,  0,
+            0, 1, 0,  0,
+            0, 0, 10, 0,
+            0, 0, 0,  10};
+        static constexpr float P0[DIM_X * DIM_X] = {
+            10, 0,  0,  0,  0,   0,   0,   0,   0,   0,
+            0,  10, 0,  0,  0,   0,   0,   0,   0,   0,
+            0,  0,  10, 0,  0,   0,   0,   0,   0,   0,
+            0,  0,  0,  10, 0,   0,   0,   0,   0,   0,
+            0,  0,  0,  0,  1e4, 0,   0,   0,   0,   0,
+            0,  0,  0,  0,  0,   1e4, 0,   0,   0,   0,
+            0,  0,  0,  0,  0,   0,   1e4, 0,   0,   0,
+            0,  0,  0,  0,  0,   0,   0,   1e4, 0,   0,
+            0,  0,  0,  0,  0,   0,   0,   0,   1e4, 0,
+            0,  0,  0,  0,  0,   0,   0,   0,   0,   1e4};
+    };
+}
@@ -0,0 +1,65 @@
+/**
+ * @desc:   parallel parameter sweep of Sort(maxAge, minHits, iouThresh) scored against ground truth.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include "det_file.h"
+#include "mot_metrics.h"
+
+namespace sort
+{
+    struct SortParams
+    {
+        int maxAge = 1;
+        int minHits = 3;
+        float iouThresh = 0.3f;
+    };
+
+    /**
+     * @brief detections and ground truth of one sequence, shared read-only by the sweep jobs
+     */
+    struct SequenceData
+    {
+        std::string name;
+        DetSequence dets;
+        DetSequence gt;     // scored: pedestrians (class 1, or 0 when unknown) with a non-zero consider flag
+    };
+
+    struct SweepResult
+    {
+        SortParams params;
+        MotMetrics metrics;                     // all sequences together
+        std::vector<MotMetrics> perSequence;    // same order as the input sequences
+    };
+
+    /**
+     * @brief load det/det and gt/gt of a MOT sequence folder, .sortdet files are preferred over .txt
+     * @param dataFolder sequence folder
+     * @return sequence data
+     */
+    SequenceData loadSequence(const std::string& dataFolder);
+
+    /**
+     * @brief run a fresh Sort over one sequence and score its output. ground truth is filtered as in the MOT
+     *        devkit: only considered pedestrians are scored, tracker boxes matched to a distractor class are
+     *        dropped. boxes are not filtered by visibility, the devkit default
+     * @param seq sequence data
+     * @param params tracker parameters
+     * @param evalIouThresh minimal IoU for a tracker box to cover a ground truth box
+     * @return metrics of the sequence
+     */
+    MotMetrics evaluateSequence(const SequenceData& seq, const SortParams& params, float evalIouThresh=0.5f);
+
+    /**
+     * @brief evaluate every parameter set on every sequence, (params, sequence) jobs run in parallel
+     * @param grid parameter sets
+     * @param seqs sequences
+     * @param numThreads number of threads, <= 0 for all hardware threads
+     * @param evalIouThresh minimal IoU for a tracker box to cover a ground truth box
+     * @return one result per parameter set, same order as grid
+     */
+    std::vector<SweepResult> sweep(const std::vector<SortParams>& grid, const std::vector<SequenceData>& seqs,
+                                   int numThreads=0, float evalIouThresh=0.5f);
+}
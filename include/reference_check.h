@@ -0,0 +1,253 @@
+/**
+ * @desc:   differential verification of the fast paths on live input. a reference tracker runs in lockstep
+ *          with a Sort using fast paths (parallel mode, SortBatch, adaptive solver, unrolled Kalman filter,
+ *          ...). the reference has the association and lifecycle rules of Sort, but runs one
+ *          cv::KalmanFilter per tracker, getIouMatrix and KuhnMunkres::compute. every frame the outputs, the
+ *          tracker ids and the filter states are compared, and the fast tracker's assignment strategy is run
+ *          on the reference association problem against KuhnMunkres. the reference takes its tracker ids
+ *          from its own sequence, so it never consumes ids of the tracker under test, and the ids of both
+ *          are compared up to a correspondence. a divergence is reported and optionally dumped as a reproducer
+ *          (reference snapshot before the frame and the frame's detections). the reference restarts from the
+ *          fast tracker's state after every frame, so each check covers one frame: the rounding differences
+ *          of the two filters do not accumulate, and one divergence does not cascade.
+ */
+#pragma once
+
+#include <opencv2/video/tracking.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include "sort.h"
+
+namespace sort
+{
+    struct ReferenceCheckReport
+    {
+        int frame = 0;                  // number of update calls of the reference, including this one
+        int numTrackers[2] = {0, 0};    // reference, fast
+        int numTracks[2] = {0, 0};      // reported tracks, reference, fast
+        float outputDrift = 0.0f;       // maximal relative difference of the reported boxes and velocities
+        float stateDrift = 0.0f;        // maximal relative difference of the filter states and covariances
+        int numIdMismatches = 0;        // trackers whose id does not follow the id correspondence
+        float assignmentGap = 0.0f;     // total IoU of the KuhnMunkres assignment above the fast solver's one
+        std::string reproducer;         // path prefix of the dump, empty if not dumped
+    };
+
+    /**
+     * @brief reference filter of a motion model: cv::KalmanFilter on the model's matrices, with the
+     *        bookkeeping of KalmanBoxTrackerT (hit streak, time since update). for verification only
+     */
+    template<class Model>
+    class ReferenceTrackerT
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ReferenceTrackerT<Model> >;
+        using State = KalmanBoxTrackerStateT<Model>;
+        static constexpr int DIM_X = Model::DIM_X;
+        static constexpr int DIM_Z = Model::DIM_Z;
+    private:
+        State state;            // bookkeeping, the filter state lives in kf
+        cv::KalmanFilter kf;
+
+    // methods
+    public:
+        /**
+         * @param state tracker state, e.g. exported by KalmanBoxTrackerT
+         */
+        explicit ReferenceTrackerT(const State& state);
+
+        /**
+         * @brief new tracker on a detection, as KalmanBoxTrackerT::reset
+         * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
+         * @param id tracker id
+         */
+        ReferenceTrackerT(const cv::Mat& bbox, int id);
+
+        virtual ~ReferenceTrackerT();
+        ReferenceTrackerT(const ReferenceTrackerT&) = delete;
+        ReferenceTrackerT& operator=(const ReferenceTrackerT&) = delete;
+
+        void exportState(State& state) const;
+
+        /**
+         * @return predicted bounding box, Mat(1, 4)
+         */
+        cv::Mat predict();
+
+        /**
+         * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
+         * @return corrected bounding box, Mat(1, 4)
+         */
+        cv::Mat update(const cv::Mat& bbox);
+
+        inline int getFilterId() const
+        {
+            return state.id;
+        }
+
+        inline int getTimeSinceUpdate() const
+        {
+            return state.timeSinceUpdate;
+        }
+
+        inline int getHitStreak() const
+        {
+            return state.hitStreak;
+        }
+
+        inline void setConfirmed()
+        {
+            state.confirmed = 1;
+        }
+
+        /**
+         * @brief covariance of the last predict, Mat(DIM_X, DIM_X), zero before the first one
+         */
+        inline const cv::Mat& getErrorCovPrior() const
+        {
+            return kf.errorCovPre;
+        }
+
+        /**
+         * @brief element k of the corrected state
+         */
+        inline float getStatePost(int k) const
+        {
+            return kf.statePost.at<float>(k, 0);
+        }
+    };
+
+    using ReferenceTracker = ReferenceTrackerT<ConstantVelocityModel>;
+
+    class ReferenceCheck
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ReferenceCheck>;
+        // the unrolled filter and cv::KalmanFilter round differently. the covariances stay ~1e-6 apart, the
+        // velocities up to ~1e-4: their correction reads the predicted area, whose rounding grows with the box
+        static constexpr float DEFAULT_TOLERANCE = 1e-3f;
+    private:
+        Sort::Ptr fast;
+        SortSnapshotHeader referenceHeader;     // parameters, caps, id sequence and frame count of the reference
+        vector<ReferenceTracker::Ptr> referenceTrackers;
+        AssociationSolver::Ptr solver;  // configured as the fast tracker's solver
+        KuhnMunkres km;
+        float tolerance;
+        std::string dumpDir;
+        std::unordered_map<int, int> idMap;     // fast tracker id -> reference tracker id, within a frame
+        std::unordered_map<int, int> idMapBack; // reference tracker id -> fast tracker id
+        vector<ReferenceCheckReport> reports;
+        int numChecked = 0;
+
+    // methods
+    public:
+        /**
+         * @param fast tracker under test, the reference starts from a snapshot of it
+         * @param tolerance maximal relative difference between the two, |a - b| <= tolerance * max(1, |b|), and
+         *        for covariance entries tolerance * max(1, sqrt(|Pp(i, i) * Pp(j, j)|)) of the predicted one
+         * @param dumpDir directory receiving the reproducers, nothing is dumped if empty
+         */
+        explicit ReferenceCheck(Sort::Ptr fast, float tolerance=DEFAULT_TOLERANCE, const std::string& dumpDir="");
+        virtual ~ReferenceCheck();
+        ReferenceCheck(const ReferenceCheck&) = delete;
+        ReferenceCheck& operator=(const ReferenceCheck&) = delete;
+
+        /**
+         * @brief update the fast tracker and check it against the reference
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @return output of the fast tracker
+         */
+        cv::Mat update(const cv::Mat &bboxesDet);
+
+        /**
+         * @brief check a fast tracker already updated by another path, e.g. SortBatch
+         * @param bboxesDet detections the fast tracker was updated with
+         * @param fastOutput output of the fast tracker
+         * @return true if both agree within the tolerance
+         */
+        bool check(const cv::Mat &bboxesDet, const cv::Mat &fastOutput);
+
+        /**
+         * @brief divergent frames so far
+         */
+        inline const vector<ReferenceCheckReport>& getReports() const
+        {
+            return reports;
+        }
+
+        inline int getNumChecked() const
+        {
+            return numChecked;
+        }
+
+        /**
+         * @brief cost of an assignment above the optimum found by KuhnMunkres, for checking other solvers
+         * @param costMatrix cost matrix, M x N
+         * @param pairs assignment to check, (row, column) pairs
+         * @return cost of pairs minus the minimal cost of a complete assignment, > 0 if pairs is not optimal
+         */
+        static float assignmentCostGap(const Vec2f& costMatrix, const TypeMatchedPairs& pairs);
+
+        /**
+         * @brief run the unrolled KalmanBoxTrackerT of a motion model and its ReferenceTrackerT side by side
+         *        on a synthetic track (noisy constant motion with missed frames), e.g. to validate a model
+         * @param numFrames frames of the track
+         * @param seed random seed
+         * @return maximal relative difference of the states and covariances, as ReferenceCheckReport::stateDrift
+         */
+        template<class Model>
+        static float motionModelDrift(int numFrames=200, unsigned seed=0);
+
+    private:
+        /**
+         * @brief relative difference, scaled by the reference value when it is larger than 1
+         */
+        static inline float drift(float value, float expected)
+        {
+            if (value != value || expected != expected)
+                return value != value && expected != expected ? 0.0f : FLT_MAX;
+            return std::fabs(value - expected) / std::max(1.0f, std::fabs(expected));
+        }
+
+        /**
+         * @brief one frame of the reference, the steps of Sort::update
+         * @param bboxesDet detections of the frame
+         * @param report receives the assignment gap of the frame
+         * @return reported tracks, as Sort::update
+         */
+        cv::Mat updateReference(const cv::Mat &bboxesDet, ReferenceCheckReport& report);
+
+        /**
+         * @brief reference state in the Sort snapshot format
+         */
+        vector<uint8_t> snapshotReference() const;
+
+        /**
+         * @brief restart the reference from a Sort snapshot
+         */
+        void restoreReference(const vector<uint8_t>& snapshot);
+
+        /**
+         * @brief assignment of the fast tracker's strategy on the reference problem of a frame, against the
+         *        optimum. a solver bounded by a maximal dimension is inexact by design, it runs unbounded here
+         * @param iouMat reference IoU matrix of the frame
+         * @return total IoU of the optimal assignment minus the one of the fast strategy
+         */
+        float solverGap(const cv::Mat &iouMat);
+
+        /**
+         * @brief check that a fast id and a reference id correspond, recording new pairs
+         */
+        bool matchIds(int fastId, int referenceId);
+
+        /**
+         * @brief write the snapshot and detections reproducing a frame
+         * @return path prefix of the dump
+         */
+        std::string dump(int frame, const vector<uint8_t>& snapshot, const cv::Mat &bboxesDet) const;
+    };
+}
@@ -0,0 +1,94 @@
+/**
+ * @desc:   front-end of Sort for detectors running asynchronously on several workers. detection batches
+ *          are pushed from any thread in any order, held in a bounded reorder window and fed to Sort in
+ *          frame order. a frame still missing when its deadline expires is coasted (predict only) and
+ *          dropped if it arrives later, so one slow worker never stalls the stream.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include "sort.h"
+
+namespace sort
+{
+    /**
+     * @brief one tracked frame, in frame order
+     */
+    struct ReorderedFrame
+    {
+        int frameIndex = -1;
+        bool coasted = false;   // the detections missed their deadline, the trackers were only predicted
+        cv::Mat tracks;         // output of Sort::update, Mat(N, 9)
+    };
+
+    class ReorderBuffer
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ReorderBuffer>;
+        using Clock = std::chrono::steady_clock;
+    private:
+        struct Pending
+        {
+            cv::Mat dets;
+            Clock::time_point arrival;
+        };
+
+        Sort::Ptr mot;
+        int window;                         // maximal number of frames buffered ahead of the next one
+        Clock::duration deadline;           // maximal wait for a missing frame once a later one arrived
+        int nextFrame;                      // next frame fed to Sort
+        bool closed = false;
+        std::map<int, Pending> pending;     // frame index -> detections, all >= nextFrame
+        std::multimap<int, Clock::time_point> waiting;  // frame index -> arrival, of the pushes beyond the window
+        std::mutex mtx;
+        std::condition_variable arrived, advanced;
+
+        size_t numLate = 0;                 // frames dropped because they arrived after being coasted
+        size_t numCoasted = 0;              // frames coasted because their detections were missing
+
+    // methods
+    public:
+        /**
+         * @param mot tracker fed in frame order, only the consumer thread may use it afterwards
+         * @param window reorder window in frames, pushes further ahead block until the window moves
+         * @param deadline maximal wait for a missing frame, counted from the first arrival of a later frame
+         * @param firstFrame index of the first frame
+         */
+        ReorderBuffer(Sort::Ptr mot, int window=8,
+                      std::chrono::milliseconds deadline=std::chrono::milliseconds(50), int firstFrame=0);
+        virtual ~ReorderBuffer();
+        ReorderBuffer(const ReorderBuffer&) = delete;
+        ReorderBuffer& operator=(const ReorderBuffer&) = delete;
+
+        /**
+         * @brief hand the detections of one frame over, any thread
+         * @param frameIndex frame index
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @return false if the frame is late (already coasted), duplicated or the buffer is closed,
+         *         the detections are dropped then
+         */
+        bool push(int frameIndex, const cv::Mat &bboxesDet);
+
+        /**
+         * @brief track the next frame, consumer thread only. blocks until its detections arrive or its
+         *        deadline expires, in which case the trackers are only predicted
+         * @param frame output frame
+         * @return false if the buffer has been closed and drained
+         */
+        bool pop(ReorderedFrame& frame);
+
+        /**
+         * @brief reject further pushes, the buffered frames are still tracked by pop
+         *        with the missing ones in between coasted
+         */
+        void close();
+
+        size_t getNumLate();
+
+        size_t getNumCoasted();
+    };
+}
@@ -0,0 +1,91 @@
+/**
+ * @desc:   SORT on huge scenes split into a grid of tiles. every tile runs its own Sort in parallel on the
+ *          detections whose center lies in the tile extended by an overlap margin. a track is reported by
+ *          the tile whose core contains its center, and a track crossing into another tile hands its
+ *          global id over to the track that tile has been following in the overlap margin. near a border two
+ *          tiles may each report their own track of one object, the duplicate is suppressed.
+ */
+#pragma once
+
+#include <unordered_map>
+#include "sort.h"
+
+namespace sort
+{
+    class ShardedSort
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ShardedSort>;
+        static constexpr float DUPLICATE_IOU = 0.7f;    // minimal IoU of two tiles' tracks of the same object
+    private:
+        float handoffIou;               // minimal IoU to hand a global id over between tiles
+        vector<Sort::Ptr> shards;       // one Sort per tile, row major
+        vector<cv::Rect2f> cores;       // tiles, a partition of the image plane
+        vector<cv::Rect2f> regions;     // tiles extended by the overlap margin
+        ThreadPool::Ptr threadPool = nullptr;
+        int frameCount = 0;
+        std::unordered_map<int, int> globalIds;     // shard tracker id -> global id, while the tracker lives
+        cv::Mat lastOutput;                         // previous output, Mat(N, 9) with global ids
+
+    // methods
+    public:
+        /**
+         * @param imageSize image plane size
+         * @param tileCols number of tile columns
+         * @param tileRows number of tile rows
+         * @param margin overlap margin in pixels, should exceed the size of an object crossing a border
+         * @param maxAge tracker's maximal unmatch count
+         * @param minHits tracker's minimal match count
+         * @param iouThresh IoU threshold of the data association, also used for the handoff
+         * @param numThreads number of threads running the tiles, <= 0 for all hardware threads
+         */
+        ShardedSort(cv::Size imageSize, int tileCols, int tileRows, int margin=64,
+                    int maxAge=1, int minHits=3, float iouThresh=0.3, int numThreads=0);
+        virtual ~ShardedSort();
+        ShardedSort(const ShardedSort&) = delete;
+        ShardedSort& operator=(const ShardedSort&) = delete;
+
+        /**
+         * @brief same contract as Sort::update, tracker ids are global across tiles
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @return matched bboxes, Mat(N, 9) with the format [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...].
+         */
+        cv::Mat update(const cv::Mat &bboxesDet);
+
+        inline int getNumTiles() const
+        {
+            return shards.size();
+        }
+
+    private:
+        /**
+         * @brief index of the tile whose core contains a point, points outside the image go to the closest tile
+         */
+        int findCore(float x, float y) const;
+
+        /**
+         * @brief drop the owned rows duplicating an owned row of another tile, rows with a global id first,
+         *        then by decreasing score. the tracker of a dropped row takes the global id of the kept one
+         * @param owned rows reported this frame, tracker_id holds shard tracker ids, compacted in place
+         * @param ownedTiles tile of every owned row, compacted in place
+         * @return (shard tracker id of a dropped row, kept row)
+         */
+        vector<pair<int, int> > suppressDuplicates(cv::Mat& owned, vector<int>& ownedTiles);
+
+        /**
+         * @brief map the shard tracker ids of the owned rows to global ids
+         * @param owned rows reported this frame, tracker_id holds shard tracker ids and is rewritten
+         * @param others rows of the overlap margins, tracker_id holds shard tracker ids
+         */
+        void reconcile(cv::Mat& owned, const cv::Mat& others);
+
+        /**
+         * @brief give the margin tracks without a global id the one of the reported track they overlap,
+         *        so a track born in a margin keeps its id when it crosses into the tile following it
+         * @param owned rows reported this frame, with global ids
+         * @param others rows of the overlap margins, tracker_id holds shard tracker ids
+         */
+        void adoptMarginTracks(const cv::Mat& owned, const cv::Mat& others);
+    };
+}
@@ -0,0 +1,307 @@
+/**
+ * @desc:   shared memory transport between detector processes and a tracker server on the same host.
+ *          the server creates one POSIX shared memory object holding a channel per detector worker. every
+ *          channel is a pair of single-producer/single-consumer rings of fixed size slots: detections go
+ *          to the server in the request ring, the tracks come back in the response ring. a worker writes
+ *          its detections in place into a request slot, the server runs Sort::update on a cv::Mat wrapping
+ *          the slot and writes the tracks in place into a response slot. waiting sides sleep on futexes,
+ *          a futex is only woken when someone sleeps on it, so a busy pipeline makes no syscall per frame.
+ *          layout:
+ *              ShmHeader                           parameters and the server doorbell
+ *              ShmChannel[numChannels]             ring indices and the worker signal
+ *              per channel, request slots then response slots, each ShmSlotHeader + records[maxDets]
+ *          Linux only (futex).
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sort.h"
+
+namespace sort
+{
+    constexpr char SHM_TRANSPORT_MAGIC[8] = {'S', 'O', 'R', 'T', 'S', 'H', 'M', '\0'};
+    constexpr uint32_t SHM_TRANSPORT_VERSION = 2;   // 2: channel owner pid
+
+    /**
+     * @brief detection record, the row layout taken by Sort::update
+     */
+    struct ShmDetection
+    {
+        float xc, yc, w, h;
+        float score;
+        float classId;
+    };
+
+    /**
+     * @brief track record, the row layout returned by Sort::update
+     */
+    struct ShmTrack
+    {
+        float xc, yc, w, h;
+        float score;
+        float classId;
+        float dx, dy;
+        float trackerId;
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "atomics shared across processes must be lock-free");
+
+    /**
+     * @brief futex backed event in shared memory, notify() only makes a syscall when a waiter sleeps
+     */
+    struct ShmSignal
+    {
+        std::atomic<uint32_t> sequence;     // futex word, bumped by every notify
+        std::atomic<uint32_t> numWaiting;
+
+        void notify();
+
+        /**
+         * @brief sleep until ready() holds
+         * @param ready condition, checked before every sleep
+         * @param timeout maximal wait
+         * @return ready()
+         */
+        template<typename _Pred>
+        bool wait(_Pred ready, std::chrono::microseconds timeout)
+        {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (true)
+            {
+                uint32_t seq = sequence.load();
+                if (ready()) return true;
+                auto left = deadline - std::chrono::steady_clock::now();
+                if (left <= left.zero()) return false;
+                numWaiting.fetch_add(1);
+                sleep(seq, std::chrono::duration_cast<std::chrono::microseconds>(left));
+                numWaiting.fetch_sub(1);
+            }
+        }
+
+    private:
+        /**
+         * @brief futex wait while sequence == seq
+         */
+        void sleep(uint32_t seq, std::chrono::microseconds timeout);
+    };
+
+    struct ShmRingIndex
+    {
+        alignas(64) std::atomic<uint32_t> head;     // next slot to read, owned by the consumer
+        alignas(64) std::atomic<uint32_t> tail;     // next slot to write, owned by the producer
+    };
+
+    struct ShmChannel
+    {
+        ShmRingIndex requests;      // worker -> server
+        ShmRingIndex responses;     // server -> worker
+        alignas(64) ShmSignal signal;   // wakes the worker: response published or request slot freed
+        std::atomic<int32_t> owner;     // pid of the attached worker, 0 if the channel is free
+        std::atomic<uint32_t> numSessions;  // attachments so far, the current worker's session
+    };
+
+    struct ShmHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numChannels;
+        uint32_t numSlots;          // slots of every ring
+        uint32_t maxDets;           // records per slot
+        uint64_t slotSize;          // bytes per slot, ShmSlotHeader included
+        alignas(64) ShmSignal doorbell; // wakes the server: request published or response slot freed
+        std::atomic<uint32_t> ready;    // layout initialized
+    };
+
+    struct ShmSlotHeader
+    {
+        int64_t frameIndex;
+        uint32_t count;             // records in the slot
+        uint32_t session;           // session of the worker the frame belongs to
+    };
+
+    /**
+     * @brief a mapping of the transport object, shared by the server and the workers
+     */
+    class ShmSegment
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ShmSegment>;
+    private:
+        std::string name;
+        bool owner = false;
+        uint8_t* ptr = nullptr;
+        size_t length = 0;
+
+    // methods
+    public:
+        /**
+         * @brief create the object (owner), or open an existing one, throws std::runtime_error on failure
+         * @param name POSIX shared memory name, e.g. "/sort"
+         * @param numChannels channels to create, 0 to open
+         * @param numSlots slots per ring when creating
+         * @param maxDets records per slot when creating
+         */
+        ShmSegment(const std::string& name, int numChannels, int numSlots, int maxDets);
+
+        /**
+         * @brief unmap, the owner also unlinks the object
+         */
+        virtual ~ShmSegment();
+        ShmSegment(const ShmSegment&) = delete;
+        ShmSegment& operator=(const ShmSegment&) = delete;
+
+        inline ShmHeader* header() const
+        {
+            return reinterpret_cast<ShmHeader*>(ptr);
+        }
+
+        inline ShmChannel* channel(int c) const
+        {
+            return reinterpret_cast<ShmChannel*>(ptr + channelOffset()) + c;
+        }
+
+        /**
+         * @brief slot i (modulo numSlots) of the request (response = false) or response ring of channel c
+         */
+        inline ShmSlotHeader* slot(int c, bool response, uint32_t i) const
+        {
+            const ShmHeader* h = header();
+            size_t index = (size_t(c) * 2 + response) * h->numSlots + i % h->numSlots;
+            return reinterpret_cast<ShmSlotHeader*>(ptr + slotsOffset(h->numChannels) + index * h->slotSize);
+        }
+
+    private:
+        static inline size_t channelOffset()
+        {
+            return (sizeof(ShmHeader) + 63) / 64 * 64;
+        }
+
+        static inline size_t slotsOffset(int numChannels)
+        {
+            return channelOffset() + numChannels * sizeof(ShmChannel);
+        }
+    };
+
+    /**
+     * @brief tracker server, one Sort per channel updated in place on the request slots.
+     *        the Sort of a channel restarts when a new worker session sends its first frame.
+     */
+    class ShmServer
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ShmServer>;
+    private:
+        ShmSegment segment;
+        int maxAge;
+        int minHits;
+        float iouThresh;
+        vector<Sort::Ptr> trackers;
+        vector<uint32_t> sessions;  // session tracked by every channel
+        long numFrames = 0;
+
+    // methods
+    public:
+        /**
+         * @brief create the transport, throws std::runtime_error on failure
+         * @param name POSIX shared memory name, e.g. "/sort"
+         * @param numChannels detector workers served, one Sort each
+         * @param numSlots slots per ring, frames in flight per worker
+         * @param maxDets detections per frame at most
+         * @param maxAge, minHits, iouThresh parameters of every Sort
+         */
+        ShmServer(const std::string& name, int numChannels, int numSlots=4, int maxDets=256,
+                  int maxAge=1, int minHits=3, float iouThresh=0.3);
+        virtual ~ShmServer();
+        ShmServer(const ShmServer&) = delete;
+        ShmServer& operator=(const ShmServer&) = delete;
+
+        /**
+         * @brief track every pending request of every channel, sleeping until one arrives if none is pending.
+         *        a channel whose response ring is full is skipped until its worker frees a slot.
+         * @param timeout maximal sleep
+         * @return frames tracked
+         */
+        int serve(std::chrono::microseconds timeout=std::chrono::milliseconds(100));
+
+        inline Sort::Ptr getTracker(int channel) const
+        {
+            return trackers[channel];
+        }
+
+        inline long getNumFrames() const
+        {
+            return numFrames;
+        }
+    };
+
+    /**
+     * @brief detector side of one channel
+     */
+    class ShmClient
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ShmClient>;
+    private:
+        ShmSegment segment;
+        int channel;
+        ShmChannel* state = nullptr;
+        uint32_t session = 0;
+        bool isHolding = false;     // a response slot is held between receive and release
+
+    // methods
+    public:
+        /**
+         * @brief attach to a channel of a running server as a new session, throws std::runtime_error if
+         *        the transport does not exist or the channel is invalid or taken. a channel whose owner
+         *        process is gone (e.g. a crashed worker) is reclaimed, the owner must run in the same
+         *        pid namespace
+         * @param name POSIX shared memory name of the server
+         * @param channel channel index
+         */
+        ShmClient(const std::string& name, int channel);
+        virtual ~ShmClient();
+        ShmClient(const ShmClient&) = delete;
+        ShmClient& operator=(const ShmClient&) = delete;
+
+        /**
+         * @brief free request slot to write the detections of the next frame into
+         * @param timeout maximal wait for the server to free a slot
+         * @return getMaxDets() records, nullptr on timeout
+         */
+        ShmDetection* acquire(std::chrono::microseconds timeout=std::chrono::seconds(1));
+
+        /**
+         * @brief hand the slot of the last acquire to the server
+         * @param frameIndex frame index, returned with the tracks
+         * @param count detections written, <= getMaxDets()
+         */
+        void submit(int64_t frameIndex, int count);
+
+        /**
+         * @brief oldest tracked frame of this session, without copying
+         * @param frameIndex output, frame index given to submit
+         * @param tracks output, Mat(N, 9) [xc, yc, w, h, score, class_id, dx, dy, tracker_id] on the slot,
+         *        valid until release()
+         * @param timeout maximal wait for the server
+         * @return false on timeout
+         */
+        bool receive(int64_t& frameIndex, cv::Mat& tracks, std::chrono::microseconds timeout=std::chrono::seconds(1));
+
+        /**
+         * @brief give the slot of the last receive back to the server, nothing if no slot is held
+         */
+        void release();
+
+        inline int getMaxDets() const
+        {
+            return segment.header()->maxDets;
+        }
+    };
+}
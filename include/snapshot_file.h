@@ -0,0 +1,64 @@
+/**
+ * @desc:   Sort snapshots kept in a shared memory mapped file for failover. the file holds two slots
+ *          written alternately, a slot becomes visible by publishing its sequence number after its
+ *          payload, so a crash in the middle of save() leaves the previous snapshot readable.
+ *          the file is never resized in place: a larger file is prepared aside with the newest snapshot
+ *          and renamed over it, so a reader keeps a consistent mapping and reopens the path on its next load.
+ *          a reader in another process may load concurrently with the single writer.
+ */
+#pragma once
+
+#include <string>
+#include "sort.h"
+
+namespace sort
+{
+    class SnapshotFile
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<SnapshotFile>;
+    private:
+        std::string path;
+        int fd = -1;
+        uint8_t* ptr = nullptr;
+        size_t length = 0;
+
+    // methods
+    public:
+        /**
+         * @brief open or create a snapshot file, throws std::runtime_error on failure
+         * @param path file path
+         */
+        explicit SnapshotFile(const std::string& path);
+
+        virtual ~SnapshotFile();
+        SnapshotFile(const SnapshotFile&) = delete;
+        SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+        /**
+         * @brief write a snapshot of mot into the older slot, the file grows when needed
+         * @param mot tracker to save
+         */
+        void save(const Sort& mot);
+
+        /**
+         * @brief restore mot from the newest complete snapshot
+         * @param mot tracker to restore
+         * @return false if the file holds no complete snapshot
+         */
+        bool load(Sort& mot);
+
+    private:
+        /**
+         * @brief reopen the path if the file was replaced, (re)map the file after its size changed
+         */
+        void remap();
+
+        /**
+         * @brief replace the file by a larger one whose slots hold at least capacity bytes,
+         *        the newest snapshot is copied and published in it before the rename
+         */
+        void reserve(size_t capacity);
+    };
+}
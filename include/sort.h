@@ -9,8 +9,17 @@
 #pragma once
 
 #include <memory>
+#include <cstdint>
+#include <functional>
 #include "kuhn_munkres.h"
 #include "kalman_box_tracker.h"
+#include "tracker_pool.h"
+#include "thread_pool.h"
+#include "spsc_ring.h"
+#include "delta_encoder.h"
+#include "trajectory_bank.h"
+#include "association_solver.h"
+#include "trace_recorder.h"
 
 namespace sort{
     using std::shared_ptr;
@@ -28,24 +37,107 @@ namespace sort{
     using TypeLostPreds = vector<int>;
     using TypeAssociate = tuple<TypeMatchedPairs, TypeLostDets, TypeLostPreds>;
 
-    class Sort
+    enum class TrackEventType : int32_t
     {
+        BORN,       // tracker created for an unmatched detection
+        CONFIRMED,  // hitStreak reached minHits for the first time, once per tracker
+        LOST,       // tracker missed its detection after being matched or created in the previous frame
+        DELETED     // tracker removed, unmatched for more than maxAge frames or diverged
+    };
+
+    struct TrackEvent
+    {
+        TrackEventType type;
+        int32_t trackerId;
+        int32_t frame;      // number of Sort::update calls including the one emitting the event
+        float bbox[4];      // [xc, yc, w, h], detection for BORN, estimate for CONFIRMED, prediction otherwise
+    };
+
+    using TrackEventRing = SpscRing<TrackEvent>;
+
+    constexpr char SORT_SNAPSHOT_MAGIC[8] = {'S', 'O', 'R', 'T', 'S', 'N', 'P', '\0'};
+    constexpr uint32_t SORT_SNAPSHOT_VERSION = 3;   // 2: frameCount header field, confirmed tracker flag
+                                                    // 3: caps and solver settings
+
+    /**
+     * @brief snapshot layout: SortSnapshotHeader followed by numTrackers KalmanBoxTrackerStateT records
+     */
+    struct SortSnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;    // sizeof(KalmanBoxTrackerStateT), changes with the motion model
+        int32_t maxAge;
+        int32_t minHits;
+        float iouThresh;
+        int32_t filterCount;    // tracker id sequence
+        uint32_t numTrackers;
+        int32_t frameCount;     // number of update calls
+        int32_t maxTracks;      // caps, 0 if unbounded, see Sort::setMaxTracks
+        int32_t maxDetections;
+        int32_t maxSolverDimension;
+        int32_t adaptiveSolver; // Sort::setAdaptiveSolver
+    };
+
+    /**
+     * @brief approximate bytes held by a Sort instance per component, allocator overhead excluded
+     */
+    struct SortMemoryUsage
+    {
+        size_t trackers = 0;        // live trackers with their Kalman filters
+        size_t pool = 0;            // released trackers kept for reuse
+        size_t solver = 0;          // association buffers and the Kuhn Munkres solver
+        size_t events = 0;          // lifecycle event ring
+        size_t trajectories = 0;    // trajectory bank
+        size_t deltas = 0;          // delta encoder of updateDelta
+        size_t recorder = 0;        // trace buffers
+        size_t self = 0;            // the Sort object and its tracker list
+
+        inline size_t total() const
+        {
+            return trackers + pool + solver + events + trajectories + deltas + recorder + self;
+        }
+    };
+
+    /**
+     * @brief SORT tracker on the motion model Model, see motion_models.h
+     */
+    template<class Model>
+    class SortT
+    {
+        template<class> friend class SortBatchT;   // predicts the trackers of many instances at once
+
     // variables
     public:
-        using Ptr = std::shared_ptr<Sort>;
+        using Ptr = std::shared_ptr<SortT<Model> >;
+        using Tracker = KalmanBoxTrackerT<Model>;
     private:
         int maxAge;         // tracker's maximal unmatch count
         int minHits;        // tracker's minimal match count
         float iouThresh;    // IoU threshold
-        vector<KalmanBoxTracker::Ptr> trackers;
-        KuhnMunkres::Ptr km = nullptr;
+        vector<typename Tracker::Ptr> trackers;
+        TrackerPoolT<Model> pool;   // recycles removed trackers
+        AssociationSolver::Ptr solver = nullptr;   // picks the assignment strategy per frame
+        ThreadPool::Ptr threadPool = nullptr;   // intra-frame parallel mode, serial when null
+        TrackEventRing::Ptr events = nullptr;   // lifecycle events, disabled when null
+        DeltaEncoder::Ptr deltaEncoder = nullptr;   // delta output mode of updateDelta
+        TrajectoryBank::Ptr trajectories = nullptr; // recent states of every tracker, disabled when null
+        TraceRecorder::Ptr recorder = nullptr;  // input trace, disabled when null
+        int frameCount = 0;
+        int maxTracks = 0;          // live trackers at most, 0 if unbounded
+        int maxDetections = 0;      // detections associated per frame at most, 0 if unbounded
+        int nextId = -1;            // next id of the private id sequence, -1 when taking the shared TrackerIds
+        cv::Mat birthDets;          // detections of the deferred births, see associate
+        TypeLostDets births;        // rows of birthDets starting a tracker
+        long numShedBirths = 0;
+        long numShedDetections = 0;
 
     // methods
     public:
-        Sort(int maxAge=1, int minHits=3, float iouThresh=0.3);
-        virtual ~Sort();
-        Sort(const Sort&) = delete;
-        Sort& operator=(const Sort&) = delete;
+        SortT(int maxAge=1, int minHits=3, float iouThresh=0.3);
+        virtual ~SortT();
+        SortT(const SortT&) = delete;
+        SortT& operator=(const SortT&) = delete;
 
         /**
          * @brief bbox tracking in SORT, this method must be called once for each frame even with empty detections, 
@@ -54,6 +146,213 @@ namespace sort{
          * @return matched bboxes, Mat(N, 9) with the format [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...].
          */
         cv::Mat update(const cv::Mat &bboxesDet);
+
+        /**
+         * @brief same as update, but only returns the tracks that appeared or changed beyond the tolerances
+         *        since they were last returned, plus the ids of the tracks no longer reported.
+         *        a DeltaDecoder applying the deltas of every frame holds the full picture.
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @return delta against the previous calls to updateDelta
+         */
+        TrackDelta updateDelta(const cv::Mat &bboxesDet);
+
+        /**
+         * @brief set the tolerances of updateDelta, the next delta carries every track again
+         * @param posTol position tolerance in pixels
+         * @param sizeTol size tolerance in pixels
+         */
+        void setDeltaTolerances(float posTol, float sizeTol);
+
+        /**
+         * @brief split tracker predict/update and IoU rows of each frame across a thread pool,
+         *        the output (including tracker order and ids) is identical to the serial mode.
+         * @param numThreads number of threads, <= 1 for the serial mode (default), 0 is not allowed
+         */
+        void setNumThreads(int numThreads);
+
+        /**
+         * @brief publish track lifecycle events (born, confirmed, lost, deleted) into a lock-free ring,
+         *        a consumer thread drains it with tryPop while update keeps running. events are dropped
+         *        and counted by the ring when the consumer falls behind, update never blocks.
+         * @param capacity ring capacity in events, 0 disables the events
+         * @return the ring to drain
+         */
+        TrackEventRing::Ptr enableEvents(size_t capacity=4096);
+
+        inline TrackEventRing::Ptr getEvents() const
+        {
+            return events;
+        }
+
+        /**
+         * @brief pick the cheapest exact assignment strategy per frame (default), or always run
+         *        Kuhn Munkres on the whole matrix
+         */
+        inline void setAdaptiveSolver(bool enable)
+        {
+            solver->setAdaptive(enable);
+        }
+
+        inline bool isAdaptiveSolver() const
+        {
+            return solver->isAdaptive();
+        }
+
+        /**
+         * @brief take tracker ids from a sequence of this instance, starting at the current shared id, instead
+         *        of the TrackerIds sequence shared by every instance. the ids no longer depend on the other
+         *        instances but may repeat theirs, e.g. for a shadow tracker that must not perturb the ids
+         * @param enable private sequence, false returns to the shared one
+         */
+        void setPrivateIds(bool enable);
+
+        /**
+         * @brief assignment strategies used so far
+         */
+        inline const AssociationStats& getAssociationStats() const
+        {
+            return solver->getStats();
+        }
+
+        /**
+         * @brief bound the removed trackers kept for reuse (TrackerPoolT::DEFAULT_CAPACITY by default),
+         *        the trackers removed beyond it are freed
+         * @param count maximal free trackers, 0 disables the recycling
+         */
+        inline void setPoolCapacity(size_t count)
+        {
+            pool.setCapacity(count);
+        }
+
+        /**
+         * @brief bound the Kuhn Munkres problems of the association, a larger one is matched greedily by
+         *        decreasing IoU instead and counted in AssociationStats::numCapped
+         * @param dimension maximal rows and columns, 0 for no bound (default)
+         */
+        inline void setMaxSolverDimension(int dimension)
+        {
+            solver->setMaxDimension(dimension);
+        }
+
+        /**
+         * @brief bound the live trackers: when the unmatched detections of a frame would exceed the bound,
+         *        only the highest scoring ones start a tracker, the others are shed and counted.
+         *        existing trackers are never dropped for a new one
+         * @param count maximal trackers, 0 for no bound (default)
+         */
+        inline void setMaxTracks(int count)
+        {
+            maxTracks = count;
+        }
+
+        /**
+         * @brief bound the detections of a frame: beyond the bound, the lowest scoring detections are shed
+         *        before the association, as if they were not given, and counted. bounds the IoU matrix
+         * @param count maximal detections per frame, 0 for no bound (default)
+         */
+        inline void setMaxDetections(int count)
+        {
+            maxDetections = count;
+        }
+
+        inline long getNumShedBirths() const
+        {
+            return numShedBirths;
+        }
+
+        inline long getNumShedDetections() const
+        {
+            return numShedDetections;
+        }
+
+        /**
+         * @brief approximate bytes held per component. the thread pool and its stacks are not counted
+         */
+        SortMemoryUsage memoryUsage() const;
+
+        /**
+         * @brief keep the last capacity states (corrected when matched, predicted otherwise) of every
+         *        live tracker, the history of a tracker is dropped when it is removed
+         * @param capacity states kept per tracker, 0 disables the trajectories
+         */
+        void enableTrajectories(size_t capacity);
+
+        /**
+         * @brief recent states of one tracker, valid until the next update
+         * @param trackerId tracker id
+         * @return view on the states from the oldest to the newest, empty if unknown or disabled
+         */
+        TrajectoryView getTrajectory(int trackerId) const;
+
+        /**
+         * @brief recent states of every live tracker, valid until the next update
+         * @return one view per tracker, empty if disabled
+         */
+        vector<TrajectoryView> getTrajectories() const;
+
+        /**
+         * @brief ids of every live tracker, reported or not, in tracker order
+         */
+        vector<int> getTrackerIds() const;
+
+        /**
+         * @brief record the input of every following update (timestamp and detections) into a binary trace,
+         *        starting with a snapshot of the current state. a background thread writes the trace, update
+         *        only copies the detections. replay it with TraceReader or the replay_trace tool. the snapshot
+         *        holds the caps and solver settings, set them before the recording starts.
+         *        throws std::runtime_error if the file cannot be written.
+         * @param path trace file, empty stops the recording and closes the trace
+         * @param bufferSize bytes buffered before a hand-off to the writer thread
+         * @return the recorder
+         */
+        TraceRecorder::Ptr enableRecording(const std::string& path, size_t bufferSize=1 << 20);
+
+        inline TraceRecorder::Ptr getRecorder() const
+        {
+            return recorder;
+        }
+
+        /**
+         * @brief size in bytes of a snapshot of the current state
+         */
+        size_t snapshotSize() const;
+
+        /**
+         * @brief write the full tracker state (parameters, caps, solver settings, trackers, id sequence) into a
+         *        caller buffer, e.g. a memory mapped file, see SnapshotFile
+         * @param buffer output buffer
+         * @param capacity buffer size in bytes
+         * @return bytes written, 0 if capacity is smaller than snapshotSize()
+         */
+        size_t snapshot(uint8_t* buffer, size_t capacity) const;
+
+        /**
+         * @brief full tracker state as a byte array
+         * @return snapshot
+         */
+        vector<uint8_t> snapshot() const;
+
+        /**
+         * @brief replace the whole state with a snapshot, parameters, caps and solver settings included.
+         *        tracker ids continue from the snapshot.
+         *        throws std::runtime_error if the snapshot is invalid, the state is left unchanged then.
+         * @param data snapshot
+         * @param size snapshot size in bytes
+         */
+        void restore(const uint8_t* data, size_t size);
+
+        inline void restore(const vector<uint8_t>& data)
+        {
+            restore(data.data(), data.size());
+        }
+
+        /**
+         * @brief IoU of bboxes
+         * @param bboxesA input bboxes A, Mat(M, 4+)
+         * @param bboxesB another input bboxes B, Mat(N, 4+)
+         * @return M x N matrix, value(i, j) means IoU of A(i) and B(j)
+         */
+        static cv::Mat getIouMatrix(const cv::Mat& bboxesA, const cv::Mat& bboxesB);
     private:
         /** 
          * @brief check if NAN value in Mat
@@ -68,6 +367,28 @@ namespace sort{
             return false;
         }
 
+        /**
+         * @brief second half of update once the trackers are predicted: drops the trackers with an invalid
+         *        prediction, associates, updates, removes the dead trackers and creates the new ones
+         * @param bboxesDet detections, Mat(M, 6), kept until the births when they are deferred
+         * @param bboxesPred predictions of the trackers in order, Mat(N, 6), compacted in place
+         * @param deferBirths leave the new trackers to createTrackers, which takes their ids
+         * @return same as update
+         */
+        cv::Mat associate(const cv::Mat &bboxesDet, cv::Mat &bboxesPred, bool deferBirths=false);
+
+        /**
+         * @brief create the trackers of the unmatched detections left by the last associate
+         */
+        void createTrackers();
+
+        /**
+         * @brief the maxDetections highest scoring detections in their order, the others are counted as shed
+         * @param bboxesDet detections, Mat(M, 6) with M > maxDetections
+         * @return kept detections, Mat(maxDetections, 6)
+         */
+        cv::Mat shedDetections(const cv::Mat &bboxesDet);
+
         /**
          * @brief data associate in SORT
          * @param bboxesDet detected bboxes, Mat(M, 4+)
@@ -77,12 +398,64 @@ namespace sort{
         TypeAssociate dataAssociate(const cv::Mat& bboxesDet, const cv::Mat& bboxesPred);
 
         /**
-         * @brief IoU of bboxes
+         * @brief IoU of rows [rowBegin, rowEnd) of bboxesA against all of bboxesB
          * @param bboxesA input bboxes A, Mat(M, 4+)
          * @param bboxesB another input bboxes B, Mat(N, 4+)
-         * @return M x N matrix, value(i, j) means IoU of A(i) and B(j)
+         * @param rowBegin first row of A
+         * @param rowEnd last row of A (exclusive)
+         * @param iouMat output, Mat(M, N) allocated by the caller
          */
-        static cv::Mat getIouMatrix(const cv::Mat& bboxesA, const cv::Mat& bboxesB);
+        static void getIouRows(const cv::Mat& bboxesA, const cv::Mat& bboxesB, int rowBegin, int rowEnd, cv::Mat& iouMat);
+
+        /**
+         * @brief run body over contiguous blocks of [0, n), on the thread pool in parallel mode
+         * @param n number of items
+         * @param body called with (begin, end) of each block
+         */
+        void parallelFor(int n, const std::function<void(int, int)>& body);
+
+        /**
+         * @brief push a lifecycle event if events are enabled
+         * @param type event type
+         * @param trackerId tracker id
+         * @param bbox [xc, yc, w, h] pointer, row of a CV_32F Mat
+         */
+        inline void emitEvent(TrackEventType type, int trackerId, const float* bbox)
+        {
+            if (events == nullptr) return;
+            events->tryPush({type, trackerId, frameCount, {bbox[0], bbox[1], bbox[2], bbox[3]}});
+        }
+
+        /**
+         * @brief append the input of an update to the trace if recording is enabled
+         */
+        inline void recordInput(const cv::Mat &bboxesDet)
+        {
+            if (recorder != nullptr)
+                recorder->record(bboxesDet);
+        }
+
+        /**
+         * @brief append a tracker state to its trajectory if trajectories are enabled
+         */
+        inline void recordState(int trackerId, const float* bbox)
+        {
+            if (trajectories != nullptr)
+                trajectories->push(trackerId, frameCount, bbox);
+        }
+
+        /**
+         * @brief forget a removed tracker's trajectory if trajectories are enabled
+         */
+        inline void dropTrajectory(int trackerId)
+        {
+            if (trajectories != nullptr)
+                trajectories->remove(trackerId);
+        }
     };
+
+    using Sort = SortT<ConstantVelocityModel>;          // the model of the SORT paper
+    using SortReduced = SortT<ReducedVelocityModel>;
+    using SortAccel = SortT<ConstantAccelerationModel>;
 }
 
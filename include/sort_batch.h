@@ -0,0 +1,53 @@
+/**
+ * @desc:   advances many small Sort instances (e.g. one per low-traffic camera) in one call. the trackers
+ *          of all streams are gathered into one structure of arrays batch and predicted in a single
+ *          vectorizable pass, then every stream runs its own data association, optionally in parallel.
+ *          the new trackers are then created serially in stream order, so the ids they take from the shared
+ *          sequence do not depend on the scheduling. the batched predict runs the operations of the
+ *          per-tracker one (see KalmanBoxTrackerT::predictBatch), so the outputs are those of calling
+ *          SortT::update on every stream in order.
+ */
+#pragma once
+
+#include "sort.h"
+
+namespace sort
+{
+    template<class Model>
+    class SortBatchT
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<SortBatchT<Model> >;
+        using Tracker = KalmanBoxTrackerT<Model>;
+        using Stream = typename SortT<Model>::Ptr;
+    private:
+        ThreadPool::Ptr threadPool = nullptr;   // runs the association of the streams, serial when null
+        vector<float> x;                        // states, element k of tracker t at x[k * capacity + t]
+        vector<float> errorCov;                 // covariances, element (i, j) of tracker t at [(i * DIM_X + j) * capacity + t]
+        vector<int> offsets;                    // first batch index of every stream
+        size_t capacity = 0;                    // trackers the batch can hold without reallocation
+
+    // methods
+    public:
+        /**
+         * @param numThreads number of threads running the association of the streams, <= 0 for all hardware threads
+         */
+        explicit SortBatchT(int numThreads=1);
+        virtual ~SortBatchT();
+        SortBatchT(const SortBatchT&) = delete;
+        SortBatchT& operator=(const SortBatchT&) = delete;
+
+        /**
+         * @brief one SortT::update on every stream
+         * @param streams trackers, each one appears at most once
+         * @param bboxesDets detections of every stream, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @return output of every stream, Mat(N, 9) with the format [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...]
+         */
+        vector<cv::Mat> update(const vector<Stream>& streams, const vector<cv::Mat>& bboxesDets);
+    };
+
+    using SortBatch = SortBatchT<ConstantVelocityModel>;    // the model of the SORT paper
+    using SortBatchReduced = SortBatchT<ReducedVelocityModel>;
+    using SortBatchAccel = SortBatchT<ConstantAccelerationModel>;
+}
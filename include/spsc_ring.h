@@ -0,0 +1,97 @@
+/**
+ * @desc:   lock-free single-producer/single-consumer ring buffer. one thread may push and
+ *          one other thread may pop concurrently, neither of them ever blocks.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace sort
+{
+    template<typename _Tp>
+    class SpscRing
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<SpscRing<_Tp> >;
+    private:
+        static constexpr size_t CACHE_LINE = 64;
+
+        std::vector<_Tp> slots;
+        size_t mask;
+        alignas(CACHE_LINE) std::atomic<size_t> head{0};    // next slot to pop, owned by the consumer
+        alignas(CACHE_LINE) std::atomic<size_t> tail{0};    // next slot to push, owned by the producer
+        alignas(CACHE_LINE) std::atomic<size_t> dropped{0}; // pushes rejected because the ring was full
+
+    // methods
+    public:
+        /**
+         * @param capacity minimal number of items, rounded up to a power of two
+         */
+        explicit SpscRing(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity) size *= 2;
+            slots.resize(size);
+            mask = size - 1;
+        }
+
+        virtual ~SpscRing()
+        {
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        /**
+         * @brief append an item, producer thread only
+         * @param item item to append
+         * @return false if the ring is full, the item is dropped and counted then
+         */
+        bool tryPush(const _Tp& item)
+        {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) > mask)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            slots[t & mask] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief take the oldest item, consumer thread only
+         * @param item output item
+         * @return false if the ring is empty
+         */
+        bool tryPop(_Tp& item)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire))
+                return false;
+            item = slots[h & mask];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        inline size_t size() const
+        {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        inline size_t capacity() const
+        {
+            return slots.size();
+        }
+
+        inline size_t getNumDropped() const
+        {
+            return dropped.load(std::memory_order_relaxed);
+        }
+    };
+}
@@ -0,0 +1,536 @@
+/**
+ * @desc:   fixed-capacity SORT for hard real-time loops. capacities are compile-time parameters, every
+ *          buffer is a std::array member, so nothing is allocated after construction and nothing throws.
+ *          same model and association as Sort: constant velocity Kalman filter on [xc, yc, s, r],
+ *          IoU cost, optimal assignment, confirmation after minHits and removal after maxAge misses.
+ *          header-only and independent of OpenCV.
+ *
+ *          worst-case execution time of update, T = MaxTracks, D = MaxDets, M = number of input detections:
+ *              detection selection     O(M log D)     (O(min(M, D)) with OverflowPolicy::DROP_LAST)
+ *              predict                 O(T)           ~250 flops per tracker
+ *              IoU matrix              O(T D)
+ *              assignment              O(min(T, D)^2 max(T, D))
+ *              correct                 O(T)           ~600 flops per tracker
+ *              births                  O(D^2)         insertion sort of the unmatched detections, in place
+ *          there is no other data dependent work: no allocation, no locking, no system call. the only sorts
+ *          are std::push_heap/pop_heap/sort, which work in place, and a hand-written insertion sort where
+ *          stability is needed (std::stable_sort may allocate). a bound for a target is measured once by
+ *          updating with D overlapping detections while T trackers are alive.
+ */
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+namespace sort
+{
+    /**
+     * @brief what to do with what does not fit in the fixed capacities
+     */
+    enum class OverflowPolicy
+    {
+        DROP_LOWEST_SCORE,  // keep the MaxDets highest-score detections, give free tracker slots to the best scores
+        DROP_LAST           // keep the first MaxDets detections, give free tracker slots in input order
+    };
+
+    struct StaticDetection
+    {
+        float bbox[4];      // [xc, yc, w, h]
+        float score;
+        int classId;
+    };
+
+    struct StaticTrack
+    {
+        float bbox[4];      // [xc, yc, w, h]
+        float score;
+        int classId;
+        float dx, dy;
+        int trackerId;
+    };
+
+    template<int MaxTracks, int MaxDets>
+    class StaticSort
+    {
+        static_assert(MaxTracks > 0 && MaxDets > 0, "capacities must be positive");
+
+    // variables
+    public:
+        static constexpr int MAX_TRACKS = MaxTracks;
+        static constexpr int MAX_DETS = MaxDets;
+        using Output = std::array<StaticTrack, MaxTracks>;
+    private:
+        static constexpr int DIM_X = 7;     // xc, yc, s, r, dxc/dt, dyc/dt, ds/dt
+        static constexpr int DIM_Z = 4;     // xc, yc, s, r
+        static constexpr int DIM_N = MaxTracks > MaxDets ? MaxTracks : MaxDets;
+
+        struct Tracker
+        {
+            int id;
+            int timeSinceUpdate;
+            int hitStreak;
+            float x[DIM_X];
+            float P[DIM_X * DIM_X];
+            float bbox[4];      // last prediction
+        };
+
+        int maxAge;
+        int minHits;
+        float iouThresh;
+        OverflowPolicy policy;
+        int nextId = 0;
+        int frameCount = 0;
+        long numDroppedDets = 0;
+        long numDroppedBirths = 0;
+
+        std::array<Tracker, MaxTracks> trackers;
+        int numTrackers = 0;
+        std::array<int, MaxDets> kept;                  // indices of the detections used this frame
+        int numKept = 0;
+        std::array<float, MaxDets * MaxTracks> iouMat;  // row major, kept detection x tracker
+        std::array<int, MaxDets> detMatch;              // tracker of every kept detection, -1 if none
+        std::array<int, MaxTracks> trackMatch;          // kept detection of every tracker, -1 if none
+
+        // assignment solver scratch, 1-based as in the potentials formulation of the Hungarian algorithm
+        std::array<float, DIM_N + 1> u, v, minv;
+        std::array<int, DIM_N + 1> p, way;
+        std::array<char, DIM_N + 1> used;
+
+    // methods
+    public:
+        /**
+         * @param maxAge tracker's maximal unmatch count
+         * @param minHits tracker's minimal match count
+         * @param iouThresh IoU threshold
+         * @param policy overflow policy of the detections and tracker slots
+         */
+        StaticSort(int maxAge=1, int minHits=3, float iouThresh=0.3,
+                   OverflowPolicy policy=OverflowPolicy::DROP_LOWEST_SCORE)
+            : maxAge(maxAge), minHits(minHits), iouThresh(iouThresh), policy(policy)
+        {
+        }
+
+        StaticSort(const StaticSort&) = delete;
+        StaticSort& operator=(const StaticSort&) = delete;
+
+        /**
+         * @brief same contract as Sort::update on fixed-size buffers, called once per frame
+         * @param bboxesDet detections
+         * @param numDets number of detections, the ones beyond MaxDets are dropped by the overflow policy
+         * @param output matched bboxes of the confirmed trackers, in detection order
+         * @return number of entries written to output
+         */
+        int update(const StaticDetection* bboxesDet, int numDets, Output& output)
+        {
+            frameCount++;
+            selectDetections(bboxesDet, numDets);
+
+            // predict, removing the trackers that diverged and keeping the order of the others
+            int numValid = 0;
+            for (int t = 0; t < numTrackers; ++t)
+            {
+                Tracker& kbt = trackers[t];
+                predict(kbt);
+                if (std::isnan(kbt.bbox[0]) || std::isnan(kbt.bbox[1]) || std::isnan(kbt.bbox[2]) || std::isnan(kbt.bbox[3]))
+                    continue;
+                if (numValid != t)
+                    trackers[numValid] = kbt;
+                numValid++;
+            }
+            numTrackers = numValid;
+
+            associate(bboxesDet);
+
+            // correct the matched trackers, the confirmed ones are reported in detection order
+            int numOutput = 0;
+            for (int k = 0; k < numKept; ++k)
+            {
+                if (detMatch[k] < 0) continue;
+                const StaticDetection& det = bboxesDet[kept[k]];
+                Tracker& kbt = trackers[detMatch[k]];
+                correct(kbt, det);
+                if (kbt.hitStreak < minHits) continue;
+
+                StaticTrack& track = output[numOutput++];
+                stateToBBox(kbt.x, track.bbox);
+                track.score = det.score;
+                track.classId = det.classId;
+                track.dx = kbt.x[4];
+                track.dy = kbt.x[5];
+                track.trackerId = kbt.id;
+            }
+
+            // remove dead trackers, keeping the order of the others
+            int numAlive = 0;
+            for (int t = 0; t < numTrackers; ++t)
+            {
+                if (trackers[t].timeSinceUpdate > maxAge) continue;
+                if (numAlive != t)
+                    trackers[numAlive] = trackers[t];
+                numAlive++;
+            }
+            numTrackers = numAlive;
+
+            createTrackers(bboxesDet);
+            return numOutput;
+        }
+
+        inline int getNumTrackers() const
+        {
+            return numTrackers;
+        }
+
+        inline int getFrameCount() const
+        {
+            return frameCount;
+        }
+
+        /**
+         * @brief detections dropped because more than MaxDets were given in one frame
+         */
+        inline long getNumDroppedDets() const
+        {
+            return numDroppedDets;
+        }
+
+        /**
+         * @brief unmatched detections that got no tracker because MaxTracks trackers were alive
+         */
+        inline long getNumDroppedBirths() const
+        {
+            return numDroppedBirths;
+        }
+
+    private:
+        /**
+         * @brief fill kept with at most MaxDets detection indices in increasing order
+         */
+        void selectDetections(const StaticDetection* bboxesDet, int numDets)
+        {
+            numKept = 0;
+            if (numDets <= MaxDets || policy == OverflowPolicy::DROP_LAST)
+            {
+                numKept = std::min(numDets, MaxDets);
+                for (int i = 0; i < numKept; ++i)
+                    kept[i] = i;
+            }
+            else
+            {
+                // min-heap on the score of the best MaxDets detections seen so far
+                auto worse = [bboxesDet](int a, int b) { return bboxesDet[a].score > bboxesDet[b].score; };
+                for (int i = 0; i < numDets; ++i)
+                {
+                    if (numKept < MaxDets)
+                    {
+                        kept[numKept++] = i;
+                        std::push_heap(kept.begin(), kept.begin() + numKept, worse);
+                    }
+                    else if (bboxesDet[i].score > bboxesDet[kept[0]].score)
+                    {
+                        std::pop_heap(kept.begin(), kept.end(), worse);
+                        kept[MaxDets - 1] = i;
+                        std::push_heap(kept.begin(), kept.end(), worse);
+                    }
+                }
+                std::sort(kept.begin(), kept.begin() + numKept);
+            }
+            numDroppedDets += numDets > numKept ? numDets - numKept : 0;
+        }
+
+        /**
+         * @brief IoU matrix and minimal cost assignment, fills detMatch and trackMatch
+         */
+        void associate(const StaticDetection* bboxesDet)
+        {
+            for (int k = 0; k < numKept; ++k) detMatch[k] = -1;
+            for (int t = 0; t < numTrackers; ++t) trackMatch[t] = -1;
+            if (numKept == 0 || numTrackers == 0) return;
+
+            for (int k = 0; k < numKept; ++k)
+            {
+                const StaticDetection& det = bboxesDet[kept[k]];
+                for (int t = 0; t < numTrackers; ++t)
+                    iouMat[k * numTrackers + t] = iou(det.bbox, trackers[t].bbox);
+            }
+
+            // the solver needs rows <= columns, the smaller side is taken as rows
+            bool detRows = numKept <= numTrackers;
+            int rows = detRows ? numKept : numTrackers;
+            int cols = detRows ? numTrackers : numKept;
+            solve(rows, cols, detRows);
+
+            // pairs overlapping less than iouThresh stay unmatched
+            for (int j = 1; j <= cols; ++j)
+            {
+                if (p[j] == 0) continue;
+                int k = detRows ? p[j] - 1 : j - 1;
+                int t = detRows ? j - 1 : p[j] - 1;
+                if (iouMat[k * numTrackers + t] < iouThresh) continue;
+                detMatch[k] = t;
+                trackMatch[t] = k;
+            }
+        }
+
+        /**
+         * @brief Hungarian algorithm with potentials on the cost 1 - IoU, O(rows^2 cols)
+         * @param rows number of rows, <= cols
+         * @param cols number of columns
+         * @param detRows rows are the kept detections, otherwise the trackers
+         * @return p[j] is the 1-based row assigned to the 1-based column j, 0 if none
+         */
+        void solve(int rows, int cols, bool detRows)
+        {
+            auto cost = [&](int i, int j) {
+                return 1.0f - (detRows ? iouMat[(i - 1) * numTrackers + (j - 1)]
+                                       : iouMat[(j - 1) * numTrackers + (i - 1)]);
+            };
+
+            for (int j = 0; j <= cols; ++j)
+            {
+                v[j] = 0;
+                p[j] = 0;
+                way[j] = 0;
+            }
+            for (int i = 0; i <= rows; ++i)
+                u[i] = 0;
+
+            for (int i = 1; i <= rows; ++i)
+            {
+                p[0] = i;
+                int j0 = 0;
+                for (int j = 0; j <= cols; ++j)
+                {
+                    minv[j] = FLT_MAX;
+                    used[j] = 0;
+                }
+                do
+                {
+                    used[j0] = 1;
+                    int i0 = p[j0], j1 = 0;
+                    float delta = FLT_MAX;
+                    for (int j = 1; j <= cols; ++j)
+                    {
+                        if (used[j]) continue;
+                        float cur = cost(i0, j) - u[i0] - v[j];
+                        if (cur < minv[j])
+                        {
+                            minv[j] = cur;
+                            way[j] = j0;
+                        }
+                        if (minv[j] < delta)
+                        {
+                            delta = minv[j];
+                            j1 = j;
+                        }
+                    }
+                    for (int j = 0; j <= cols; ++j)
+                    {
+                        if (used[j])
+                        {
+                            u[p[j]] += delta;
+                            v[j] -= delta;
+                        }
+                        else
+                            minv[j] -= delta;
+                    }
+                    j0 = j1;
+                } while (p[j0] != 0);
+                do
+                {
+                    int j1 = way[j0];
+                    p[j0] = p[j1];
+                    j0 = j1;
+                } while (j0 != 0);
+            }
+        }
+
+        /**
+         * @brief new trackers for the unmatched detections while slots are free
+         */
+        void createTrackers(const StaticDetection* bboxesDet)
+        {
+            // unmatched detections, compacted at the front of detMatch
+            int numLost = 0;
+            for (int k = 0; k < numKept; ++k)
+                if (detMatch[k] < 0)
+                    detMatch[numLost++] = kept[k];
+
+            int numFree = MaxTracks - numTrackers;
+            if (numLost > numFree)
+            {
+                // in-place insertion sort by decreasing score, stable so ties keep the input order.
+                // std::stable_sort may allocate a merge buffer, which update must never do
+                if (policy == OverflowPolicy::DROP_LOWEST_SCORE)
+                    for (int k = 1; k < numLost; ++k)
+                    {
+                        int idx = detMatch[k];
+                        int j = k;
+                        for (; j > 0 && bboxesDet[detMatch[j - 1]].score < bboxesDet[idx].score; --j)
+                            detMatch[j] = detMatch[j - 1];
+                        detMatch[j] = idx;
+                    }
+                numDroppedBirths += numLost - numFree;
+                numLost = numFree;
+            }
+
+            for (int k = 0; k < numLost; ++k)
+            {
+                const StaticDetection& det = bboxesDet[detMatch[k]];
+                Tracker& kbt = trackers[numTrackers++];
+                kbt.id = nextId++;
+                kbt.timeSinceUpdate = 0;
+                kbt.hitStreak = 0;
+                for (int i = 0; i < DIM_X * DIM_X; ++i)
+                    kbt.P[i] = 0;
+                for (int i = 0; i < DIM_X; ++i)
+                {
+                    kbt.x[i] = 0;
+                    kbt.P[i * DIM_X + i] = i < DIM_Z ? 10 : 1e4;
+                }
+                bboxToZ(det.bbox, kbt.x);
+            }
+        }
+
+        /**
+         * @brief x = F*x, P = F*P*Ft + Q, F adds the velocities (rows 4, 5, 6) to xc, yc, s (rows 0, 1, 2)
+         */
+        void predict(Tracker& kbt)
+        {
+            static constexpr float PROCESS_NOISE[DIM_X] = {1, 1, 1, 1, 1e-2, 1e-2, 1e-4};
+            float* x = kbt.x;
+            float* P = kbt.P;
+
+            // bbox area (ds/dt + s) shouldn't be negtive
+            if (x[6] + x[2] <= 0)
+                x[6] *= 0;
+            for (int i = 0; i < 3; ++i)
+                x[i] += x[i + 4];
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < DIM_X; ++j)
+                    P[i * DIM_X + j] += P[(i + 4) * DIM_X + j];
+            for (int i = 0; i < DIM_X; ++i)
+                for (int j = 0; j < 3; ++j)
+                    P[i * DIM_X + j] += P[i * DIM_X + j + 4];
+            for (int i = 0; i < DIM_X; ++i)
+                P[i * DIM_X + i] += PROCESS_NOISE[i];
+
+            stateToBBox(x, kbt.bbox);
+            kbt.hitStreak = kbt.timeSinceUpdate > 0 ? 0 : kbt.hitStreak;
+            kbt.timeSinceUpdate++;
+        }
+
+        /**
+         * @brief Kalman correction with H selecting [xc, yc, s, r]: S = P[0:4, 0:4] + R,
+         *        X = S^-1 * P[0:4, :] by Cholesky, x += Xt * (z - x[0:4]), P -= Xt * P[0:4, :]
+         */
+        void correct(Tracker& kbt, const StaticDetection& det)
+        {
+            static constexpr float MEASUREMENT_NOISE[DIM_Z] = {1, 1, 10, 10};
+            float* x = kbt.x;
+            float* P = kbt.P;
+
+            // innovation covariance and its Cholesky factor L, S = L*Lt
+            float L[DIM_Z][DIM_Z] = {};
+            for (int i = 0; i < DIM_Z; ++i)
+                for (int j = 0; j <= i; ++j)
+                {
+                    float sum = P[i * DIM_X + j] + (i == j ? MEASUREMENT_NOISE[i] : 0.0f);
+                    for (int k = 0; k < j; ++k)
+                        sum -= L[i][k] * L[j][k];
+                    L[i][j] = i == j ? std::sqrt(sum) : sum / L[j][j];
+                }
+
+            // X = S^-1 * HP, one forward and one backward substitution per column of HP = P[0:4, :]
+            float X[DIM_Z][DIM_X];
+            for (int c = 0; c < DIM_X; ++c)
+            {
+                for (int i = 0; i < DIM_Z; ++i)
+                {
+                    float sum = P[i * DIM_X + c];
+                    for (int k = 0; k < i; ++k)
+                        sum -= L[i][k] * X[k][c];
+                    X[i][c] = sum / L[i][i];
+                }
+                for (int i = DIM_Z - 1; i >= 0; --i)
+                {
+                    float sum = X[i][c];
+                    for (int k = i + 1; k < DIM_Z; ++k)
+                        sum -= L[k][i] * X[k][c];
+                    X[i][c] = sum / L[i][i];
+                }
+            }
+
+            float z[DIM_Z];
+            bboxToZ(det.bbox, z);
+            float y[DIM_Z];
+            for (int i = 0; i < DIM_Z; ++i)
+                y[i] = z[i] - x[i];
+
+            // the gain is K = Xt, HP is read before P is overwritten
+            float HP[DIM_Z * DIM_X];
+            std::copy(P, P + DIM_Z * DIM_X, HP);
+            for (int r = 0; r < DIM_X; ++r)
+            {
+                for (int i = 0; i < DIM_Z; ++i)
+                    x[r] += X[i][r] * y[i];
+                for (int c = 0; c < DIM_X; ++c)
+                    for (int i = 0; i < DIM_Z; ++i)
+                        P[r * DIM_X + c] -= X[i][r] * HP[i * DIM_X + c];
+            }
+
+            kbt.timeSinceUpdate = 0;
+            kbt.hitStreak += 1;
+        }
+
+        /**
+         * @brief same measure as Sort::getIouMatrix: integer boxes, intersection over enclosing box
+         */
+        static float iou(const float* a, const float* b)
+        {
+            int ax = int(a[0] - a[2] / 2.0), ay = int(a[1] - a[3] / 2.0), aw = int(a[2]), ah = int(a[3]);
+            int bx = int(b[0] - b[2] / 2.0), by = int(b[1] - b[3] / 2.0), bw = int(b[2]), bh = int(b[3]);
+
+            int ix = std::max(ax, bx), iy = std::max(ay, by);
+            int iw = std::min(ax + aw, bx + bw) - ix, ih = std::min(ay + ah, by + bh) - iy;
+            float inter = iw > 0 && ih > 0 ? float(iw) * ih : 0.0f;
+
+            float outer;
+            if (aw <= 0 || ah <= 0)
+                outer = bw > 0 && bh > 0 ? float(bw) * bh : 0.0f;
+            else if (bw <= 0 || bh <= 0)
+                outer = float(aw) * ah;
+            else
+            {
+                int ox = std::min(ax, bx), oy = std::min(ay, by);
+                outer = float(std::max(ax + aw, bx + bw) - ox) * (std::max(ay + ah, by + bh) - oy);
+            }
+            return inter / (outer + FLT_EPSILON);
+        }
+
+        /**
+         * @brief [xc, yc, w, h] to [xc, yc, s, r]
+         */
+        static inline void bboxToZ(const float* bbox, float* z)
+        {
+            z[0] = bbox[0];
+            z[1] = bbox[1];
+            z[2] = bbox[2] * bbox[3];
+            z[3] = bbox[2] / bbox[3];
+        }
+
+        /**
+         * @brief [xc, yc, s, r, ...] to [xc, yc, w, h]
+         */
+        static inline void stateToBBox(const float* x, float* bbox)
+        {
+            float w = std::sqrt(x[2] * x[3]);
+            bbox[0] = x[0];
+            bbox[1] = x[1];
+            bbox[2] = w;
+            bbox[3] = x[2] / w;
+        }
+    };
+}
@@ -0,0 +1,68 @@
+/**
+ * @desc:   fixed size pool of worker threads running indexed tasks.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sort
+{
+    class ThreadPool
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<ThreadPool>;
+        using Task = std::function<void(int)>;
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mtx;
+        std::condition_variable wakeUp, finished;
+        const Task* task = nullptr;     // job currently being run
+        int numTasks = 0;
+        std::atomic<int> nextTask{0};
+        int busyWorkers = 0;
+        size_t generation = 0;
+        bool stopping = false;
+
+    // methods
+    public:
+        /**
+         * @brief start the worker threads
+         * @param numThreads number of threads including the caller, <= 0 for all hardware threads
+         */
+        explicit ThreadPool(int numThreads=0);
+
+        virtual ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief run task(0), ..., task(numTasks - 1) on the pool and the calling thread,
+         *        returns when all of them are done. indices are handed out dynamically,
+         *        so tasks must not depend on which thread runs them. not reentrant,
+         *        only one thread may call run at a time.
+         * @param numTasks number of tasks
+         * @param task task body, called with the task index
+         */
+        void run(int numTasks, const Task& task);
+
+        inline int getNumThreads() const
+        {
+            return workers.size() + 1;
+        }
+
+    private:
+        void workerLoop();
+
+        /**
+         * @brief take task indices until none is left
+         */
+        void drain(const Task& job, int count);
+    };
+}
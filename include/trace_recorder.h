@@ -0,0 +1,176 @@
+/**
+ * @desc:   input traces of Sort for offline replay. the recorder appends the detections of every update to
+ *          a buffer that a background thread writes out, two buffers are swapped so update only copies
+ *          the detections and never waits for the disk unless the writer falls a whole buffer behind.
+ *          trace layout (little endian):
+ *              TraceHeader
+ *              uint8   snapshot[snapshotSize]      Sort snapshot when the recording started
+ *              records, each TraceRecord followed by float dets[numDets][6]
+ *          a trace cut by a crash stays readable up to its last complete record.
+ */
+#pragma once
+
+#include <opencv2/core/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mapped_file.h"
+
+namespace sort
+{
+    constexpr char TRACE_FILE_MAGIC[8] = {'S', 'O', 'R', 'T', 'T', 'R', 'C', '\0'};
+    constexpr uint32_t TRACE_FILE_VERSION = 1;
+
+    struct TraceHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t snapshotSize;  // bytes of the snapshot following the header
+    };
+
+    struct TraceRecord
+    {
+        int64_t timestamp;      // steady clock, nanoseconds
+        uint32_t numDets;
+        uint32_t reserved;
+    };
+
+    class TraceRecorder
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<TraceRecorder>;
+    private:
+        std::string path;
+        std::ofstream ofs;
+        size_t bufferSize;
+        std::vector<uint8_t> front;     // filled by record, owned by the recording thread
+        std::vector<uint8_t> back;      // being written, owned by the writer while pending
+        bool pending = false;
+        bool stopping = false;
+        std::atomic<bool> failed{false};    // a write failed, set by the writer, polled by record without the lock
+        std::mutex mutex;
+        std::condition_variable handedOff;  // back is pending, or stopping
+        std::condition_variable written;    // back is free again
+        std::thread writer;
+        long numFrames = 0;
+        long numStalls = 0;
+
+    // methods
+    public:
+        /**
+         * @brief create a trace, throws std::runtime_error if the file cannot be written
+         * @param path output file
+         * @param snapshot state of the recorded Sort, the replay starts from it
+         * @param bufferSize bytes buffered before a hand-off to the writer thread
+         */
+        TraceRecorder(const std::string& path, const std::vector<uint8_t>& snapshot, size_t bufferSize=1 << 20);
+
+        /**
+         * @brief write the remaining records and close the trace
+         */
+        virtual ~TraceRecorder();
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        /**
+         * @brief append the input of one update, throws std::runtime_error if a previous write failed
+         * @param bboxesDet detections, Mat(M, 6) [xc, yc, w, h, score, class_id]
+         */
+        void record(const cv::Mat &bboxesDet);
+
+        /**
+         * @brief write everything recorded so far and wait for it, throws std::runtime_error on failure
+         */
+        void flush();
+
+        inline const std::string& getPath() const
+        {
+            return path;
+        }
+
+        inline long getNumFrames() const
+        {
+            return numFrames;
+        }
+
+        /**
+         * @brief hand-offs that waited for the writer, the buffer is too small for the disk if this grows
+         */
+        inline long getNumStalls() const
+        {
+            return numStalls;
+        }
+
+        /**
+         * @brief approximate bytes held by the recorder, both buffers reserved at their full size
+         */
+        inline size_t memoryUsage() const
+        {
+            return sizeof(*this) + 2 * bufferSize;
+        }
+
+    private:
+        /**
+         * @brief give the front buffer to the writer, waiting for the previous one to be written
+         */
+        void handOff();
+
+        /**
+         * @brief writer thread
+         */
+        void run();
+    };
+
+    class TraceReader
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<TraceReader>;
+    private:
+        MappedFile file;
+        const TraceHeader* header = nullptr;
+        std::vector<size_t> offsets;    // offset of every complete record
+
+    // methods
+    public:
+        /**
+         * @brief map a trace, throws std::runtime_error if it is not valid
+         * @param path trace file
+         */
+        explicit TraceReader(const std::string& path);
+
+        virtual ~TraceReader();
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+
+        inline int getNumFrames() const
+        {
+            return offsets.size();
+        }
+
+        /**
+         * @brief Sort snapshot taken when the recording started
+         */
+        std::vector<uint8_t> getSnapshot() const;
+
+        /**
+         * @brief recording time of frame k
+         * @param k frame index in [0, getNumFrames())
+         * @return steady clock, nanoseconds
+         */
+        int64_t getTimestamp(int k) const;
+
+        /**
+         * @brief detections of frame k without copying, valid while the reader lives
+         * @param k frame index in [0, getNumFrames())
+         * @return Mat(M, 6) [xc, yc, w, h, score, class_id]
+         */
+        cv::Mat getDetections(int k) const;
+    };
+}
@@ -0,0 +1,86 @@
+/**
+ * @desc:   free-list arena recycling KalmanBoxTrackerT objects, a released tracker is reused
+ *          in place, so short lived tracks cost no allocation.
+ *          the free list is bounded, trackers released beyond its capacity are freed, so a burst of
+ *          detections does not keep its trackers allocated for the lifetime of the pool.
+ */
+#pragma once
+
+#include <vector>
+#include "kalman_box_tracker.h"
+
+namespace sort
+{
+    template<class Model>
+    class TrackerPoolT
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<TrackerPoolT<Model> >;
+        using Tracker = KalmanBoxTrackerT<Model>;
+        static constexpr size_t DEFAULT_CAPACITY = 64;
+    private:
+        std::vector<typename Tracker::Ptr> freeList;
+        size_t capacity = DEFAULT_CAPACITY;     // released trackers kept at most
+
+    // methods
+    public:
+        TrackerPoolT();
+        virtual ~TrackerPoolT();
+        TrackerPoolT(const TrackerPoolT&) = delete;
+        TrackerPoolT& operator=(const TrackerPoolT&) = delete;
+
+        /**
+         * @brief get a tracker initialized on bbox, a released one is reset in place when available
+         * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
+         * @param id tracker id, the next id of the shared sequence if negative
+         * @return tracker with a new id
+         */
+        typename Tracker::Ptr acquire(const cv::Mat &bbox, int id=-1);
+
+        /**
+         * @brief get a tracker restored from a copied state, a released one is overwritten when available
+         * @param state tracker state, its id is kept
+         * @return restored tracker
+         */
+        typename Tracker::Ptr acquire(const typename Tracker::State &state);
+
+        /**
+         * @brief give a tracker back to the pool, the caller must not use it anymore.
+         *        it is freed instead when the pool already holds capacity trackers
+         * @param tracker tracker to recycle
+         */
+        void release(typename Tracker::Ptr tracker);
+
+        /**
+         * @brief bound the released trackers kept for reuse, the ones above the bound are freed at once
+         * @param count maximal free trackers, 0 disables the recycling
+         */
+        void setCapacity(size_t count);
+
+        /**
+         * @brief make count trackers available for acquire, building the missing ones in one block, e.g. before
+         *        restoring a snapshot. the block is freed with the last of its trackers. the free list may go
+         *        above the capacity until the trackers are acquired
+         * @param count free trackers wanted
+         */
+        void reserve(size_t count);
+
+        inline size_t getCapacity() const
+        {
+            return capacity;
+        }
+
+        inline size_t getNumFree() const
+        {
+            return freeList.size();
+        }
+
+        /**
+         * @brief approximate bytes held by the released trackers and the free list
+         */
+        size_t memoryUsage() const;
+    };
+
+    using TrackerPool = TrackerPoolT<ConstantVelocityModel>;
+}
@@ -0,0 +1,139 @@
+/**
+ * @desc:   bounded trajectories of the live trackers. the last K states of every tracker are kept
+ *          in fixed size rings laid out back to back in one arena, slots of removed trackers are
+ *          recycled, so memory is constant per track and scans over all tracks are contiguous.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace sort
+{
+    struct TrajectoryPoint
+    {
+        int32_t frame;
+        float xc, yc, w, h;
+    };
+
+    /**
+     * @brief non-owning view on a contiguous range of points
+     */
+    struct TrajectorySpan
+    {
+        const TrajectoryPoint* data = nullptr;
+        size_t size = 0;
+
+        inline const TrajectoryPoint* begin() const
+        {
+            return data;
+        }
+
+        inline const TrajectoryPoint* end() const
+        {
+            return data + size;
+        }
+    };
+
+    /**
+     * @brief trajectory of one tracker from the oldest to the newest point: first, then second.
+     *        the views are valid until the next change of the bank (i.e. the next Sort::update).
+     */
+    struct TrajectoryView
+    {
+        int trackerId = -1;
+        TrajectorySpan first, second;
+
+        inline size_t size() const
+        {
+            return first.size + second.size;
+        }
+
+        inline const TrajectoryPoint& operator[](size_t i) const
+        {
+            return i < first.size ? first.data[i] : second.data[i - first.size];
+        }
+
+        inline const TrajectoryPoint& back() const
+        {
+            return (*this)[size() - 1];
+        }
+    };
+
+    class TrajectoryBank
+    {
+    // variables
+    public:
+        using Ptr = std::shared_ptr<TrajectoryBank>;
+    private:
+        struct Slot
+        {
+            int trackerId = -1;     // -1 when free
+            uint32_t head = 0;      // index of the oldest point
+            uint32_t size = 0;
+        };
+
+        size_t capacity;                        // points per trajectory
+        std::vector<TrajectoryPoint> points;    // slot s owns [s * capacity, (s + 1) * capacity)
+        std::vector<Slot> slots;
+        std::vector<int> freeSlots;
+        std::unordered_map<int, int> slotOf;    // tracker id -> slot
+
+    // methods
+    public:
+        /**
+         * @param capacity number of points kept per trajectory
+         */
+        explicit TrajectoryBank(size_t capacity);
+        virtual ~TrajectoryBank();
+        TrajectoryBank(const TrajectoryBank&) = delete;
+        TrajectoryBank& operator=(const TrajectoryBank&) = delete;
+
+        /**
+         * @brief append a point to a trajectory, the oldest one is overwritten when full
+         * @param trackerId tracker id, a slot is taken on its first point
+         * @param frame frame number
+         * @param bbox [xc, yc, w, h]
+         */
+        void push(int trackerId, int frame, const float* bbox);
+
+        /**
+         * @brief drop a trajectory and recycle its slot
+         * @param trackerId tracker id
+         */
+        void remove(int trackerId);
+
+        /**
+         * @brief view on the trajectory of one tracker
+         * @param trackerId tracker id
+         * @return empty view if the tracker has no trajectory
+         */
+        TrajectoryView get(int trackerId) const;
+
+        /**
+         * @brief views on every trajectory, in slot order
+         * @return views, no point is copied
+         */
+        std::vector<TrajectoryView> getAll() const;
+
+        inline size_t getCapacity() const
+        {
+            return capacity;
+        }
+
+        inline size_t getNumTrajectories() const
+        {
+            return slotOf.size();
+        }
+
+        /**
+         * @brief approximate bytes held by the bank, allocator overhead excluded
+         */
+        size_t memoryUsage() const;
+
+    private:
+        TrajectoryView makeView(int slot) const;
+    };
+}
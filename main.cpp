@@ -3,7 +3,10 @@
 #include <filesystem>
 #include <assert.h>
 #include <map>
+#include <thread>
 #include "sort.h"
+#include "det_file.h"
+#include "bounded_queue.h"
 
 namespace fs = std::filesystem;
 
@@ -26,23 +29,15 @@ using cv::RNG;
 using cv::Point;
 
 using sort::Sort;
+using sort::BoundedQueue;
 
 auto constexpr MAX_COLORS = 2022;
+auto constexpr QUEUE_SIZE = 8;      // frames buffered between two pipeline stages
 vector<Scalar> COLORS;
 
-vector<string> split(const string& s, char delim) {
-    std::istringstream iss(s);
-    vector<string> ret;
-    string item;
-    while (getline(iss, item, delim))
-        ret.push_back(item);
-
-    return ret;
-}
-
-// (seq info, [(image, detection), ...])
-tuple<map<string, string>, vector<pair<Mat, Mat>>> getInputData(string dataFolder, bool useGT=false) {
-    if (*dataFolder.end() != '/') dataFolder += '/';
+// (seq info, image paths, detections of each frame)
+tuple<map<string, string>, vector<string>, vector<Mat>> getInputData(string dataFolder, bool useGT=false) {
+    if (dataFolder.back() != '/') dataFolder += '/';
 
     ifstream ifs;
     ifs.open(dataFolder + "seqinfo.ini");
@@ -62,39 +57,26 @@ tuple<map<string, string>, vector<pair<Mat, Mat>>> getInputData(string dataFolde
     assert(mp.find("frameRate") != mp.end());
     assert(mp.find("seqLength") != mp.end());
 
-    // get file list
+    // get file list, images are decoded lazily by the pipeline
     vector<string> imgPaths;
     for (const auto& entry : fs::directory_iterator(dataFolder + mp["imDir"]))
         imgPaths.push_back(entry.path());
     std::sort(imgPaths.begin(), imgPaths.end());
     assert(imgPaths.size() == std::stoi(mp["seqLength"]));
 
-    vector<pair<Mat, Mat>> pairs(imgPaths.size(), {Mat(0, 0, CV_32F), Mat(0, 6, CV_32F)});
+    vector<Mat> dets(imgPaths.size(), Mat(0, 6, CV_32F));
 
-    // read images
-    for (int i = 0; i < imgPaths.size(); ++i)
-        pairs[i].first = cv::imread(imgPaths[i]);
-
-    // read detections
-    if (useGT) ifs.open(dataFolder + "/gt/gt.txt");
-    else ifs.open(dataFolder + "/det/det.txt");
-    assert (ifs.is_open());
-    float x0, y0, w, h, score;
-    int frameId, objId;
-    while (getline(ifs, s)) {
-        vector<string> ss = split(s, ',');
-        frameId = stoi(ss[0]);
-        objId = stoi(ss[1]);
-        x0 = stof(ss[2]);
-        y0 = stof(ss[3]);
-        w = stof(ss[4]);
-        h = stof(ss[5]);
-        score = stof(ss[6]);
-        Mat bbox = (Mat_<float>(1, 6) << x0 + w/2, y0 + h/2, w, h, score, 0);
-        cv::vconcat(pairs[frameId-1].second, bbox, pairs[frameId-1].second);
+    // read detections, the binary format is preferred when it has been converted
+    string detPath = dataFolder + (useGT ? "gt/gt" : "det/det");
+    detPath += fs::exists(detPath + ".sortdet") ? ".sortdet" : ".txt";
+    sort::DetSequence seq = sort::readDetections(detPath);
+    for (size_t k = 0; k < seq.dets.size(); ++k) {
+        int frameId = seq.firstFrame + k;
+        if (frameId >= 1 && frameId <= (int)dets.size())
+            dets[frameId-1] = seq.dets[k];
     }
-    
-    return std::make_tuple(mp, pairs);
+
+    return std::make_tuple(mp, imgPaths, dets);
 }
 
 void draw(Mat& img, const Mat& bboxes) {
@@ -119,7 +101,7 @@ void draw(Mat& img, const Mat& bboxes) {
 }
 
 int main(int argc, char** argv)
-{   
+{
     // generate colors
     RNG rng(MAX_COLORS);
     for (size_t i = 0; i < MAX_COLORS; ++i) {
@@ -128,32 +110,71 @@ int main(int argc, char** argv)
     }
 
     cout << "SORT demo" << endl;
-    if (argc != 2) {
-        cout << "usage: ./demo_sort [data folder], e.g. ./demo_sort ../data/TUD-Campus/" << endl;
+    if (argc != 2 && argc != 3) {
+        cout << "usage: ./demo_sort [data folder] [output], e.g. ./demo_sort ../data/TUD-Campus/" << endl;
+        cout << "       output is optional, a video file (e.g. out.avi) or a folder for an image sequence," << endl;
+        cout << "       the demo runs headless when it is given" << endl;
         return -1;
     }
     string dataFolder = argv[1];
-    // string dataFolder = "../data/TUD-Stadtmitte/";
-    
-    // read image and detections
-    cout << "Read image and detections..." << endl;    
-    auto [seqInfo, motPairs] = getInputData(dataFolder);
+    string output = argc == 3 ? argv[2] : "";
+    bool headless = !output.empty();
+    bool toVideo = headless && fs::path(output).has_extension();
+
+    // read image paths and detections
+    cout << "Read detections..." << endl;
+    auto [seqInfo, imgPaths, motDets] = getInputData(dataFolder);
     float fps = std::stof(seqInfo["frameRate"]);
 
-    // tracking
+    // pipeline: decode -> render <- track, every stage on its own thread except render,
+    // which stays on the main thread for HighGUI
     cout << "Tracking..." << endl;
-    Sort::Ptr mot = std::make_shared<Sort>(1, 3, 0.3f);
-    cv::namedWindow("SORT", cv::WindowFlags::WINDOW_NORMAL);
-    for (auto [img, bboxesDet] : motPairs) {
-        Mat bboxesPost = mot->update(bboxesDet);
-        
-        // show result
+    BoundedQueue<Mat> decoded(QUEUE_SIZE);
+    BoundedQueue<Mat> tracked(QUEUE_SIZE);
+
+    std::thread decoder([&]() {
+        for (const string& path : imgPaths)
+            if (!decoded.push(cv::imread(path))) break;
+        decoded.close();
+    });
+
+    std::thread tracker([&]() {
+        Sort::Ptr mot = std::make_shared<Sort>(1, 3, 0.3f);
+        for (const Mat& bboxesDet : motDets)
+            if (!tracked.push(mot->update(bboxesDet))) break;
+        tracked.close();
+    });
+
+    cv::VideoWriter writer;
+    if (headless && !toVideo)
+        fs::create_directories(output);
+    else if (!headless)
+        cv::namedWindow("SORT", cv::WindowFlags::WINDOW_NORMAL);
+
+    Mat img, bboxesPost;
+    for (int frame = 1; decoded.pop(img) && tracked.pop(bboxesPost); ++frame) {
         draw(img, bboxesPost);
-        cv::imshow("SORT", img);
-        cv::waitKey(1000.0 / fps);
+
+        if (!headless) {
+            cv::imshow("SORT", img);
+            cv::waitKey(1000.0 / fps);
+        } else if (toVideo) {
+            if (!writer.isOpened())
+                writer.open(output, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, img.size());
+            writer.write(img);
+        } else {
+            char name[16];
+            snprintf(name, sizeof(name), "%06d.jpg", frame);
+            cv::imwrite((fs::path(output) / name).string(), img);
+        }
     }
-    
+    decoded.close();
+    tracked.close();
+    decoder.join();
+    tracker.join();
+    writer.release();
+
     cout << "Done" << endl;
 
     return 0;
-}
\ No newline at end of file
+}
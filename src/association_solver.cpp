@@ -0,0 +1,246 @@
+#include "association_solver.h"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <tuple>
+
+using namespace sort;
+using kuhn_munkres::Vec1f;
+using kuhn_munkres::Vec2f;
+
+AssociationSolver::AssociationSolver()
+{
+    km = std::make_shared<kuhn_munkres::KuhnMunkres>();
+}
+
+
+AssociationSolver::~AssociationSolver()
+{
+}
+
+
+AssociationSolver::Pairs AssociationSolver::solve(const cv::Mat& iouMat, bool positiveOnly)
+{
+    int numRows = iouMat.rows, numCols = iouMat.cols;
+    rowMatch.assign(numRows, -1);
+    colMatch.assign(numCols, -1);
+
+    // overlap graph and its connected components
+    parent.resize(numRows + numCols);
+    std::iota(parent.begin(), parent.end(), 0);
+    int numEdges = 0;
+    for (int i = 0; i < numRows; ++i)
+    {
+        const float* row = iouMat.ptr<float>(i);
+        for (int j = 0; j < numCols; ++j)
+            if (row[j] > 0)
+            {
+                numEdges++;
+                parent[findRoot(i)] = findRoot(numRows + j);
+            }
+    }
+
+    compRows.clear();
+    compCols.clear();
+    std::vector<int> compOf(numRows + numCols, -1);   // root -> component
+    auto component = [&](int v) {
+        int& c = compOf[findRoot(v)];
+        if (c < 0)
+        {
+            c = compRows.size();
+            compRows.emplace_back();
+            compCols.emplace_back();
+        }
+        return c;
+    };
+    for (int i = 0; i < numRows; ++i)
+        compRows[component(i)].push_back(i);
+    for (int j = 0; j < numCols; ++j)
+        compCols[component(numRows + j)].push_back(j);
+    int numLinked = 0;
+    for (size_t c = 0; c < compRows.size(); ++c)
+        numLinked += !compRows[c].empty() && !compCols[c].empty();
+
+    // one dense component gains nothing from the decomposition
+    bool isDense = !adaptive || !positiveOnly ||
+                   (numLinked == 1 && numEdges >= DENSE_DENSITY * numRows * numCols);
+    SolverType frameStrategy = SolverType::GREEDY;
+    if (isDense)
+    {
+        std::vector<int> rows(numRows), cols(numCols);
+        std::iota(rows.begin(), rows.end(), 0);
+        std::iota(cols.begin(), cols.end(), 0);
+        if (fits(numRows, numCols))
+        {
+            solveKuhnMunkres(iouMat, rows, cols);
+            frameStrategy = SolverType::DENSE;
+            stats.numComponents[int(SolverType::DENSE)]++;
+        }
+        else
+        {
+            solveGreedy(iouMat, rows, cols, true);
+            stats.numComponents[int(SolverType::GREEDY)]++;
+            stats.numCapped++;
+        }
+    }
+    else
+    {
+        for (size_t c = 0; c < compRows.size(); ++c)
+        {
+            const std::vector<int>& rows = compRows[c];
+            const std::vector<int>& cols = compCols[c];
+            if (rows.empty() || cols.empty()) continue;     // isolated vertex
+
+            SolverType strategy;
+            if (solveGreedy(iouMat, rows, cols))
+                strategy = SolverType::GREEDY;
+            else if (std::max(rows.size(), cols.size()) <= BRUTE_FORCE_SIZE)
+            {
+                solveBruteForce(iouMat, rows, cols);
+                strategy = SolverType::BRUTE_FORCE;
+            }
+            else if (fits(rows.size(), cols.size()))
+            {
+                solveKuhnMunkres(iouMat, rows, cols);
+                strategy = SolverType::SPARSE;
+            }
+            else
+            {
+                solveGreedy(iouMat, rows, cols, true);
+                strategy = SolverType::GREEDY;
+                stats.numCapped++;
+            }
+            stats.numComponents[int(strategy)]++;
+            frameStrategy = std::max(frameStrategy, strategy);
+        }
+    }
+
+    stats.numFrames++;
+    stats.numFrameStrategies[int(frameStrategy)]++;
+    stats.lastStrategy = frameStrategy;
+
+    Pairs pairs;
+    for (int i = 0; i < numRows; ++i)
+        if (rowMatch[i] >= 0 && (!positiveOnly || iouMat.at<float>(i, rowMatch[i]) > 0))
+            pairs.push_back({i, rowMatch[i]});
+    return pairs;
+}
+
+
+void AssociationSolver::solveKuhnMunkres(const cv::Mat& iouMat, const std::vector<int>& rows, const std::vector<int>& cols)
+{
+    Vec2f costMatrix(rows.size(), Vec1f(cols.size(), 0.0f));
+    for (size_t a = 0; a < rows.size(); ++a)
+        for (size_t b = 0; b < cols.size(); ++b)
+            costMatrix[a][b] = 1.0f - iouMat.at<float>(rows[a], cols[b]);
+
+    for (auto [a, b] : km->compute(costMatrix))
+    {
+        rowMatch[rows[a]] = cols[b];
+        colMatch[cols[b]] = rows[a];
+    }
+}
+
+
+bool AssociationSolver::solveGreedy(const cv::Mat& iouMat, const std::vector<int>& rows, const std::vector<int>& cols, bool keep)
+{
+    std::vector<std::tuple<float, int, int> > edges;
+    for (int i : rows)
+        for (int j : cols)
+            if (iouMat.at<float>(i, j) > 0)
+                edges.push_back(std::make_tuple(-iouMat.at<float>(i, j), i, j));
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<std::pair<int, int> > chosen;
+    for (auto [negIou, i, j] : edges)
+    {
+        if (rowMatch[i] >= 0 || colMatch[j] >= 0) continue;
+        rowMatch[i] = j;
+        colMatch[j] = i;
+        chosen.push_back({i, j});
+    }
+
+    // dual certificate: potentials equal to the matched IoU on one side and 0 elsewhere are feasible
+    // when no pair overlaps more than the match of its row (or of its column)
+    bool rowsBest = true, colsBest = true;
+    for (auto [negIou, i, j] : edges)
+    {
+        rowsBest = rowsBest && rowMatch[i] >= 0 && -negIou <= iouMat.at<float>(i, rowMatch[i]);
+        colsBest = colsBest && colMatch[j] >= 0 && -negIou <= iouMat.at<float>(colMatch[j], j);
+    }
+    if (rowsBest || colsBest || keep) return rowsBest || colsBest;
+
+    for (auto [i, j] : chosen)
+    {
+        rowMatch[i] = -1;
+        colMatch[j] = -1;
+    }
+    return false;
+}
+
+
+void AssociationSolver::solveBruteForce(const cv::Mat& iouMat, const std::vector<int>& rows, const std::vector<int>& cols)
+{
+    // map the smaller side into the larger one
+    bool byRow = rows.size() <= cols.size();
+    const std::vector<int>& small = byRow ? rows : cols;
+    const std::vector<int>& large = byRow ? cols : rows;
+    auto weight = [&](int a, int b) {
+        return byRow ? iouMat.at<float>(small[a], large[b]) : iouMat.at<float>(large[b], small[a]);
+    };
+
+    int n = small.size(), m = large.size();
+    int current[BRUTE_FORCE_SIZE], best[BRUTE_FORCE_SIZE];
+    float bestTotal = -1.0f;
+    std::function<void(int, unsigned, float)> search = [&](int a, unsigned used, float total) {
+        if (a == n)
+        {
+            if (total > bestTotal)
+            {
+                bestTotal = total;
+                std::copy(current, current + n, best);
+            }
+            return;
+        }
+        for (int b = 0; b < m; ++b)
+        {
+            if (used & (1u << b)) continue;
+            current[a] = b;
+            search(a + 1, used | (1u << b), total + weight(a, b));
+        }
+    };
+    search(0, 0, 0.0f);
+
+    for (int a = 0; a < n; ++a)
+    {
+        int i = byRow ? small[a] : large[best[a]];
+        int j = byRow ? large[best[a]] : small[a];
+        rowMatch[i] = j;
+        colMatch[j] = i;
+    }
+}
+
+
+size_t AssociationSolver::memoryUsage() const
+{
+    size_t bytes = sizeof(*this) + km->memoryUsage();
+    bytes += (parent.capacity() + rowMatch.capacity() + colMatch.capacity()) * sizeof(int);
+    for (const auto* comps : {&compRows, &compCols})
+    {
+        bytes += comps->capacity() * sizeof(std::vector<int>);
+        for (const auto& comp : *comps)
+            bytes += comp.capacity() * sizeof(int);
+    }
+    return bytes;
+}
+
+
+int AssociationSolver::findRoot(int v)
+{
+    while (parent[v] != v)
+    {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
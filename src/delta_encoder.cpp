@@ -0,0 +1,88 @@
+#include "delta_encoder.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace sort;
+
+DeltaEncoder::DeltaEncoder(float posTol, float sizeTol)
+    : posTol(posTol), sizeTol(sizeTol)
+{
+}
+
+
+DeltaEncoder::~DeltaEncoder()
+{
+}
+
+
+TrackDelta DeltaEncoder::encode(const cv::Mat &bboxesPost)
+{
+    assert(bboxesPost.rows == 0 || bboxesPost.cols == 9);
+    TrackDelta delta;
+    delta.updated = cv::Mat(0, 9, CV_32F);
+
+    std::unordered_map<int, cv::Vec4f> current;
+    for (int i = 0; i < bboxesPost.rows; ++i)
+    {
+        const float* row = bboxesPost.ptr<float>(i);
+        int trackerId = row[8];
+        cv::Vec4f box(row[0], row[1], row[2], row[3]);
+
+        auto it = sent.find(trackerId);
+        bool changed = it == sent.end() ||
+                       std::fabs(box[0] - it->second[0]) > posTol || std::fabs(box[1] - it->second[1]) > posTol ||
+                       std::fabs(box[2] - it->second[2]) > sizeTol || std::fabs(box[3] - it->second[3]) > sizeTol;
+        if (changed)
+            delta.updated.push_back(bboxesPost.rowRange(i, i + 1));
+
+        // the reference only moves when a row is sent, so small drifts cannot add up
+        current[trackerId] = changed ? box : it->second;
+    }
+
+    for (const auto& [trackerId, box] : sent)
+        if (current.find(trackerId) == current.end())
+            delta.removed.push_back(trackerId);
+    std::sort(delta.removed.begin(), delta.removed.end());
+
+    sent.swap(current);
+    return delta;
+}
+
+
+void DeltaEncoder::reset()
+{
+    sent.clear();
+}
+
+
+DeltaDecoder::DeltaDecoder()
+{
+}
+
+
+DeltaDecoder::~DeltaDecoder()
+{
+}
+
+
+void DeltaDecoder::apply(const TrackDelta &delta)
+{
+    for (int trackerId : delta.removed)
+        tracks.erase(trackerId);
+    for (int i = 0; i < delta.updated.rows; ++i)
+        tracks[int(delta.updated.at<float>(i, 8))] = delta.updated.rowRange(i, i + 1).clone();
+}
+
+
+cv::Mat DeltaDecoder::getTracks() const
+{
+    std::vector<int> ids;
+    for (const auto& [trackerId, row] : tracks)
+        ids.push_back(trackerId);
+    std::sort(ids.begin(), ids.end());
+
+    cv::Mat bboxes(0, 9, CV_32F);
+    for (int trackerId : ids)
+        bboxes.push_back(tracks.at(trackerId));
+    return bboxes;
+}
@@ -0,0 +1,250 @@
+#include "det_file.h"
+#include <assert.h>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace sort;
+
+namespace
+{
+    constexpr uint64_t ALIGNMENT = 64;
+
+    inline uint64_t alignUp(uint64_t offset)
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    /**
+     * @brief true if count items of itemSize bytes at offset fit in size bytes, aligned for the item type
+     */
+    inline bool fitsIn(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t alignment, uint64_t size)
+    {
+        // no product nor sum that may overflow
+        return offset <= size && offset % alignment == 0 && count <= (size - offset) / itemSize;
+    }
+
+    template<typename _Tp>
+    inline const _Tp* column(const uint8_t* base, uint64_t offset)
+    {
+        return reinterpret_cast<const _Tp*>(base + offset);
+    }
+}
+
+
+DetFileReader::DetFileReader(const std::string& path)
+    : file(path)
+{
+    if (file.size() < sizeof(DetFileHeader))
+        throw std::runtime_error("truncated detection file " + path);
+
+    header = reinterpret_cast<const DetFileHeader*>(file.data());
+    if (memcmp(header->magic, DET_FILE_MAGIC, sizeof(DET_FILE_MAGIC)) != 0)
+        throw std::runtime_error("not a detection file " + path);
+    if (header->version != DET_FILE_VERSION)
+        throw std::runtime_error("unsupported detection file version " + path);
+
+    if (!fitsIn(header->indexOffset, header->numFrames, sizeof(DetFileFrame), alignof(DetFileFrame), file.size()))
+        throw std::runtime_error("truncated detection file " + path);
+    for (int c = 0; c < DET_FILE_NUM_COLS; ++c)
+        if (!fitsIn(header->colOffsets[c], header->numDets, sizeof(float), alignof(float), file.size()))
+            throw std::runtime_error("truncated detection file " + path);
+    if (header->numFrames > uint32_t(INT_MAX) ||
+        int64_t(header->firstFrame) + header->numFrames > int64_t(INT_MAX) + 1)
+        throw std::runtime_error("invalid frame range in detection file " + path);
+
+    // getFrame trusts the index, every entry must stay within the columns
+    index = column<DetFileFrame>(file.data(), header->indexOffset);
+    for (uint32_t k = 0; k < header->numFrames; ++k)
+        if (index[k].first > header->numDets || index[k].count > header->numDets - index[k].first)
+            throw std::runtime_error("invalid index entry " + std::to_string(k) + " in detection file " + path);
+}
+
+
+DetFileReader::~DetFileReader()
+{
+}
+
+
+DetFrameView DetFileReader::getFrame(int k) const
+{
+    assert(k >= 0 && k < getNumFrames());
+    const uint8_t* base = file.data();
+    const DetFileFrame& entry = index[k];
+
+    DetFrameView view;
+    view.frameId = header->firstFrame + k;
+    view.count = entry.count;
+    view.xc = column<float>(base, header->colOffsets[0]) + entry.first;
+    view.yc = column<float>(base, header->colOffsets[1]) + entry.first;
+    view.w = column<float>(base, header->colOffsets[2]) + entry.first;
+    view.h = column<float>(base, header->colOffsets[3]) + entry.first;
+    view.score = column<float>(base, header->colOffsets[4]) + entry.first;
+    view.classId = column<int32_t>(base, header->colOffsets[5]) + entry.first;
+    view.objId = column<int32_t>(base, header->colOffsets[6]) + entry.first;
+    return view;
+}
+
+
+cv::Mat DetFileReader::getDetections(int k) const
+{
+    DetFrameView view = getFrame(k);
+    cv::Mat dets(view.count, 6, CV_32F);
+    for (int i = 0; i < view.count; ++i)
+    {
+        float* row = dets.ptr<float>(i);
+        row[0] = view.xc[i];
+        row[1] = view.yc[i];
+        row[2] = view.w[i];
+        row[3] = view.h[i];
+        row[4] = view.score[i];
+        row[5] = view.classId[i];
+    }
+    return dets;
+}
+
+
+bool sort::isDetFile(const std::string& path)
+{
+    char magic[sizeof(DET_FILE_MAGIC)] = {0};
+    std::ifstream ifs(path, std::ios::binary);
+    ifs.read(magic, sizeof(magic));
+    return ifs.good() && memcmp(magic, DET_FILE_MAGIC, sizeof(DET_FILE_MAGIC)) == 0;
+}
+
+
+DetSequence sort::readMotText(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+        throw std::runtime_error("cannot open " + path);
+
+    DetSequence seq;
+    std::string line, item;
+    float v[8];
+    while (getline(ifs, line))
+    {
+        std::istringstream iss(line);
+        int n = 0;
+        while (n < 8 && getline(iss, item, ','))
+            v[n++] = std::stof(item);
+        if (n < 7) continue;
+        // the class column of MOT16+ ground truth, -1 (unused) elsewhere
+        float classId = n == 8 && v[7] > 0 ? v[7] : 0;
+
+        // [frame, id, x0, y0, w, h, score, class, ...] -> [xc, yc, w, h, score, class_id]
+        int frameId = v[0];
+        if (frameId < seq.firstFrame)
+            throw std::runtime_error("invalid frame " + std::to_string(frameId) + " in " + path);
+        if (frameId - seq.firstFrame >= (int)seq.dets.size())
+        {
+            seq.dets.resize(frameId - seq.firstFrame + 1);
+            seq.ids.resize(frameId - seq.firstFrame + 1);
+        }
+        cv::Mat& dets = seq.dets[frameId - seq.firstFrame];
+        if (dets.empty()) dets = cv::Mat(0, 6, CV_32F);
+        cv::Mat bbox = (cv::Mat_<float>(1, 6) << v[2] + v[4] / 2, v[3] + v[5] / 2, v[4], v[5], v[6], classId);
+        dets.push_back(bbox);
+        seq.ids[frameId - seq.firstFrame].push_back(v[1]);
+    }
+
+    for (auto& dets : seq.dets)
+        if (dets.empty()) dets = cv::Mat(0, 6, CV_32F);
+
+    return seq;
+}
+
+
+DetSequence sort::readDetFile(const std::string& path)
+{
+    DetFileReader reader(path);
+    DetSequence seq;
+    seq.firstFrame = reader.getFirstFrame();
+    seq.dets.resize(reader.getNumFrames());
+    seq.ids.resize(reader.getNumFrames());
+    for (int k = 0; k < reader.getNumFrames(); ++k)
+    {
+        DetFrameView view = reader.getFrame(k);
+        seq.dets[k] = reader.getDetections(k);
+        seq.ids[k].assign(view.objId, view.objId + view.count);
+    }
+    return seq;
+}
+
+
+DetSequence sort::readDetections(const std::string& path)
+{
+    return isDetFile(path) ? readDetFile(path) : readMotText(path);
+}
+
+
+void sort::writeDetFile(const std::string& path, const DetSequence& seq)
+{
+    assert(seq.ids.empty() || seq.ids.size() == seq.dets.size());
+
+    DetFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DET_FILE_MAGIC, sizeof(DET_FILE_MAGIC));
+    header.version = DET_FILE_VERSION;
+    header.numFrames = seq.dets.size();
+    header.firstFrame = seq.firstFrame;
+
+    std::vector<DetFileFrame> index(seq.dets.size());
+    for (size_t k = 0; k < seq.dets.size(); ++k)
+    {
+        assert(seq.dets[k].rows == 0 || seq.dets[k].cols >= 6);
+        index[k].first = header.numDets;
+        index[k].count = seq.dets[k].rows;
+        index[k].reserved = 0;
+        header.numDets += seq.dets[k].rows;
+    }
+
+    // gather columns
+    std::vector<std::vector<float> > fcols(5, std::vector<float>(header.numDets));
+    std::vector<std::vector<int32_t> > icols(2, std::vector<int32_t>(header.numDets, -1));
+    for (size_t k = 0; k < seq.dets.size(); ++k)
+    {
+        const cv::Mat& dets = seq.dets[k];
+        for (int i = 0; i < dets.rows; ++i)
+        {
+            uint64_t r = index[k].first + i;
+            for (int c = 0; c < 5; ++c)
+                fcols[c][r] = dets.at<float>(i, c);
+            icols[0][r] = dets.at<float>(i, 5);
+            if (!seq.ids.empty() && i < (int)seq.ids[k].size())
+                icols[1][r] = seq.ids[k][i];
+        }
+    }
+
+    // lay out sections
+    uint64_t offset = alignUp(sizeof(DetFileHeader));
+    header.indexOffset = offset;
+    offset = alignUp(offset + index.size() * sizeof(DetFileFrame));
+    for (int c = 0; c < DET_FILE_NUM_COLS; ++c)
+    {
+        header.colOffsets[c] = offset;
+        offset = alignUp(offset + header.numDets * sizeof(float));
+    }
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
+        throw std::runtime_error("cannot open " + path);
+
+    auto writeAt = [&ofs](uint64_t pos, const void* src, size_t bytes) {
+        static const char zeros[ALIGNMENT] = {0};
+        while ((uint64_t)ofs.tellp() < pos)
+            ofs.write(zeros, std::min<uint64_t>(ALIGNMENT, pos - ofs.tellp()));
+        ofs.write(static_cast<const char*>(src), bytes);
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.indexOffset, index.data(), index.size() * sizeof(DetFileFrame));
+    for (int c = 0; c < 5; ++c)
+        writeAt(header.colOffsets[c], fcols[c].data(), fcols[c].size() * sizeof(float));
+    for (int c = 0; c < 2; ++c)
+        writeAt(header.colOffsets[5 + c], icols[c].data(), icols[c].size() * sizeof(int32_t));
+
+    if (!ofs.good())
+        throw std::runtime_error("cannot write " + path);
+}
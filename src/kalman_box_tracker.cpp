@@ -2,86 +2,338 @@
 
 using namespace sort;
 
-int KalmanBoxTracker::count = 0;
-
-KalmanBoxTracker::KalmanBoxTracker(const cv::Mat &bbox)
-{   
-    id = KalmanBoxTracker::count;
-    KalmanBoxTracker::count++;
-
-    kf = std::make_shared<cv::KalmanFilter>(KF_DIM_X, KF_DIM_Z);  // no control vector
-    // state transition matrix (A), x(k) = A*x(k-1) + B*u(k) + w(k)
-    kf->transitionMatrix = (cv::Mat_<float>(KF_DIM_X, KF_DIM_X) <<
-                                1, 0, 0, 0, 1, 0, 0,
-                                0, 1, 0, 0, 0, 1, 0,
-                                0, 0, 1, 0, 0, 0, 1,
-                                0, 0, 0, 1, 0, 0, 0,
-                                0, 0, 0, 0, 1, 0, 0,
-                                0, 0, 0, 0, 0, 1, 0,
-                                0, 0, 0, 0, 0, 0, 1);
-    // measurement matrix (H), z(k) = H*x(k) + v(k)
-    kf->measurementMatrix = (cv::Mat_<float>(KF_DIM_Z, KF_DIM_X) <<
-                                1, 0, 0, 0, 0, 0, 0,
-                                0, 1, 0, 0, 0, 0, 0,
-                                0, 0, 1, 0, 0, 0, 0,
-                                0, 0, 0, 1, 0, 0, 0);
-    // measurement noise covariance matrix (R), K(k) = P`(k)*Ct*inv(C*P`(k)*Ct + R)
-    kf->measurementNoiseCov = (cv::Mat_<float>(KF_DIM_Z, KF_DIM_Z) <<
-                                1,  0,  0,  0,
-                                0,  1,  0,  0,
-                                0,  0,  10, 0,
-                                0,  0,  0,  10);
+namespace
+{
+    /**
+     * @brief true if F is upper triangular with a unit diagonal: row i of F*x only reads rows >= i of x,
+     *        so F*x can be computed in place by increasing rows, and P*Ft by increasing columns
+     */
+    template<class Model>
+    constexpr bool isUnitUpperTriangular()
+    {
+        for (int i = 0; i < Model::DIM_X; ++i)
+            for (int j = 0; j <= i; ++j)
+                if (Model::F[i * Model::DIM_X + j] != (i == j ? 1.0f : 0.0f))
+                    return false;
+        return true;
+    }
+
+    constexpr size_t SHARED_PTR_OVERHEAD = 16;  // control block of std::make_shared
+
+    /**
+     * @brief x = F*x and P = F*P*Ft + Q in place on n states, element k of state t at x[k * stride + t].
+     *        F and Q are compile-time constants, the zero products are skipped. the per-tracker predict
+     *        inlines it with n = stride = 1, so a batched and a single predict run the same operations
+     */
+    template<class Model>
+    inline void predictStates(float* x, float* errorCov, size_t n, size_t stride)
+    {
+        static_assert(isUnitUpperTriangular<Model>(), "the predict runs in place");
+        constexpr int DIM_X = Model::DIM_X;
+        constexpr const float* F = Model::F;
+        constexpr const float* Q = Model::Q;
+
+        if constexpr (Model::VS >= 0)
+        {
+            float* vs = x + Model::VS * stride;
+            const float* s = x + 2 * stride;
+            for (size_t t = 0; t < n; ++t)
+                if (vs[t] + s[t] <= 0)  // bbox area (ds/dt + s) shouldn't be negtive
+                    vs[t] *= 0;
+        }
+
+        // F*x: row i only reads rows > i, still unchanged. every sum is accumulated in double and rounded
+        // once, as cv::gemm does for float matrices
+        for (int i = 0; i < DIM_X; ++i)
+        {
+            float* xi = x + i * stride;
+            for (size_t t = 0; t < n; ++t)
+            {
+                double sum = xi[t];
+                for (int k = i + 1; k < DIM_X; ++k)
+                    if (F[i * DIM_X + k] != 0)
+                        sum += F[i * DIM_X + k] * x[k * stride + t];
+                xi[t] = sum;
+            }
+        }
+
+        // F*P: row i = sum of F(i, k) * row k
+        for (int i = 0; i < DIM_X; ++i)
+            for (int j = 0; j < DIM_X; ++j)
+            {
+                float* pij = errorCov + (i * DIM_X + j) * stride;
+                for (size_t t = 0; t < n; ++t)
+                {
+                    double sum = pij[t];
+                    for (int k = i + 1; k < DIM_X; ++k)
+                        if (F[i * DIM_X + k] != 0)
+                            sum += F[i * DIM_X + k] * errorCov[(k * DIM_X + j) * stride + t];
+                    pij[t] = sum;
+                }
+            }
+
+        // (F*P)*Ft: column j = sum of F(j, k) * column k
+        for (int j = 0; j < DIM_X; ++j)
+            for (int i = 0; i < DIM_X; ++i)
+            {
+                float* pij = errorCov + (i * DIM_X + j) * stride;
+                for (size_t t = 0; t < n; ++t)
+                {
+                    double sum = pij[t];
+                    for (int k = j + 1; k < DIM_X; ++k)
+                        if (F[j * DIM_X + k] != 0)
+                            sum += F[j * DIM_X + k] * errorCov[(i * DIM_X + k) * stride + t];
+                    pij[t] = sum;
+                }
+            }
+
+        // + Q
+        for (int i = 0; i < DIM_X; ++i)
+            for (int j = 0; j < DIM_X; ++j)
+            {
+                if (Q[i * DIM_X + j] == 0) continue;
+                float* pij = errorCov + (i * DIM_X + j) * stride;
+                for (size_t t = 0; t < n; ++t)
+                    pij[t] += Q[i * DIM_X + j];
+            }
+    }
+
+    /**
+     * @brief Kalman correction in place, the equations of cv::KalmanFilter::correct:
+     *        S = H*P*Ht + R, K = P*Ht*S^-1, x += K*(z - H*x), P -= K*H*P.
+     *        K is solved as X = S^-1*(H*P) = Kt with the Cholesky factor of S, P being symmetric.
+     *        products are accumulated in double and rounded once, as cv::gemm does for float matrices,
+     *        so that the cancellation in P -= K*H*P rounds as in the reference
+     */
+    template<class Model>
+    inline void correctState(float* x, float* P, const float* z)
+    {
+        constexpr int DIM_X = Model::DIM_X;
+        constexpr int DIM_Z = Model::DIM_Z;
+        constexpr const float* H = Model::H;
+        constexpr const float* R = Model::R;
+
+        // H*P, read before P is overwritten
+        float HP[DIM_Z * DIM_X];
+        for (int i = 0; i < DIM_Z; ++i)
+            for (int c = 0; c < DIM_X; ++c)
+            {
+                double sum = 0;
+                for (int k = 0; k < DIM_X; ++k)
+                    if (H[i * DIM_X + k] != 0)
+                        sum += H[i * DIM_X + k] * P[k * DIM_X + c];
+                HP[i * DIM_X + c] = sum;
+            }
+
+        // innovation covariance S = (H*P)*Ht + R and its Cholesky factor L, S = L*Lt
+        double L[DIM_Z][DIM_Z] = {};
+        for (int i = 0; i < DIM_Z; ++i)
+            for (int j = 0; j <= i; ++j)
+            {
+                double sum = 0;
+                for (int k = 0; k < DIM_X; ++k)
+                    if (H[j * DIM_X + k] != 0)
+                        sum += HP[i * DIM_X + k] * H[j * DIM_X + k];
+                sum = float(sum) + R[i * DIM_Z + j];
+                for (int k = 0; k < j; ++k)
+                    sum -= L[i][k] * L[j][k];
+                L[i][j] = i == j ? sqrt(sum) : sum / L[j][j];
+            }
+
+        // X = S^-1 * HP, one forward and one backward substitution per column of HP
+        float X[DIM_Z][DIM_X];
+        for (int c = 0; c < DIM_X; ++c)
+        {
+            double col[DIM_Z];
+            for (int i = 0; i < DIM_Z; ++i)
+            {
+                double sum = HP[i * DIM_X + c];
+                for (int k = 0; k < i; ++k)
+                    sum -= L[i][k] * col[k];
+                col[i] = sum / L[i][i];
+            }
+            for (int i = DIM_Z - 1; i >= 0; --i)
+            {
+                double sum = col[i];
+                for (int k = i + 1; k < DIM_Z; ++k)
+                    sum -= L[k][i] * col[k];
+                col[i] = sum / L[i][i];
+            }
+            for (int i = 0; i < DIM_Z; ++i)
+                X[i][c] = col[i];
+        }
+
+        // residual y = z - H*x
+        float y[DIM_Z];
+        for (int i = 0; i < DIM_Z; ++i)
+        {
+            double sum = 0;
+            for (int k = 0; k < DIM_X; ++k)
+                if (H[i * DIM_X + k] != 0)
+                    sum += H[i * DIM_X + k] * x[k];
+            y[i] = z[i] - float(sum);
+        }
+
+        for (int r = 0; r < DIM_X; ++r)
+        {
+            double gain = 0;
+            for (int i = 0; i < DIM_Z; ++i)
+                gain += X[i][r] * y[i];
+            x[r] += float(gain);
+            for (int c = 0; c < DIM_X; ++c)
+            {
+                double sum = 0;
+                for (int i = 0; i < DIM_Z; ++i)
+                    sum += X[i][r] * HP[i * DIM_X + c];
+                P[r * DIM_X + c] -= float(sum);
+            }
+        }
+    }
+}
+
+std::atomic<int> TrackerIds::count{0};
+
+template<class Model>
+KalmanBoxTrackerT<Model>::KalmanBoxTrackerT(const cv::Mat &bbox, int id)
+{
+    reset(bbox, id);
+}
+
+
+template<class Model>
+KalmanBoxTrackerT<Model>::KalmanBoxTrackerT(const State &state)
+{
+    importState(state);
+}
+
+
+template<class Model>
+KalmanBoxTrackerT<Model>::KalmanBoxTrackerT()
+    : id(-1)
+{
+}
+
+
+template<class Model>
+void KalmanBoxTrackerT<Model>::reset(const cv::Mat &bbox, int id)
+{
+    this->id = id < 0 ? TrackerIds::count++ : id;
+    timeSinceUpdate = 0;
+    hitStreak = 0;
+    confirmed = false;
+    hasPost = false;
+
     // posteriori error estimate covariance matrix (P(k)): P(k)=(I-K(k)*H)*P'(k)
-    kf->errorCovPost = (cv::Mat_<float>(KF_DIM_X, KF_DIM_X) <<
-                                10, 0,  0,  0,  0,   0,   0,
-                                0,  10, 0,  0,  0,   0,   0,
-                                0,  0,  10, 0,  0,   0,   0,
-                                0,  0,  0,  10, 0,   0,   0,
-                                0,  0,  0,  0,  1e4, 0,   0,
-                                0,  0,  0,  0,  0,   1e4, 0,
-                                0,  0,  0,  0,  0,   0,   1e4);
-    // process noise covariance matrix (Q), P'(k) = A*P(k-1)*At + Q
-    kf->processNoiseCov = (cv::Mat_<float>(KF_DIM_X, KF_DIM_X) <<
-                                1, 0, 0, 0, 0,    0,    0,
-                                0, 1, 0, 0, 0,    0,    0,
-                                0, 0, 1, 0, 0,    0,    0,
-                                0, 0, 0, 1, 0,    0,    0,
-                                0, 0, 0, 0, 1e-2, 0,    0,
-                                0, 0, 0, 0, 0,    1e-2, 0,
-                                0, 0, 0, 0, 0,    0,    1e-4);
-    // corrected state (x(k)): x(k)=x'(k)+K(k)*(z(k)-H*x'(k))
-    cv::vconcat(convertBBoxToZ(bbox),
-                cv::Mat(KF_DIM_X - KF_DIM_Z, 1, CV_32F, cv::Scalar(0)),
-                kf->statePost);
+    std::copy(Model::P0, Model::P0 + DIM_X * DIM_X, P.begin());
+    // corrected state (x(k)): x(k)=x'(k)+K(k)*(z(k)-H*x'(k)), velocities start at 0
+    x.fill(0);
+    convertBBoxToZ(bbox, x.data());
 }
 
 
-KalmanBoxTracker::~KalmanBoxTracker()
+template<class Model>
+void KalmanBoxTrackerT<Model>::exportState(State &state) const
 {
+    state.id = id;
+    state.timeSinceUpdate = timeSinceUpdate;
+    state.hitStreak = hitStreak;
+    state.hasPost = hasPost;
+    state.confirmed = confirmed;
+    std::copy(x.begin(), x.end(), state.statePost);
+    std::copy(P.begin(), P.end(), state.errorCovPost);
 }
 
 
-cv::Mat KalmanBoxTracker::update(const cv::Mat &bbox)
+template<class Model>
+void KalmanBoxTrackerT<Model>::importState(const State &state)
+{
+    id = state.id;
+    timeSinceUpdate = state.timeSinceUpdate;
+    hitStreak = state.hitStreak;
+    confirmed = state.confirmed;
+    hasPost = state.hasPost;
+    std::copy(state.statePost, state.statePost + DIM_X, x.begin());
+    std::copy(state.errorCovPost, state.errorCovPost + DIM_X * DIM_X, P.begin());
+}
+
+
+template<class Model>
+KalmanBoxTrackerT<Model>::~KalmanBoxTrackerT()
+{
+}
+
+
+template<class Model>
+cv::Mat KalmanBoxTrackerT<Model>::update(const cv::Mat &bbox)
 {
     timeSinceUpdate = 0;
     hitStreak += 1;
-    xPost = kf->correct(convertBBoxToZ(bbox));
-    cv::Mat bboxPost = convertXToBBox(xPost);
-    return bboxPost;
+    float z[DIM_Z];
+    convertBBoxToZ(bbox, z);
+    correctState<Model>(x.data(), P.data(), z);
+    hasPost = true;
+    return convertXToBBox(x.data());
 }
 
 
-cv::Mat KalmanBoxTracker::predict()
+template<class Model>
+cv::Mat KalmanBoxTrackerT<Model>::predict()
 {
-    // bbox area (ds/dt + s) shouldn't be negtive
-    if (kf->statePost.at<float>(6, 0) + kf->statePost.at<float>(2, 0) <= 0)
-        kf->statePost.at<float>(6, 0) *= 0;
+    predictStates<Model>(x.data(), P.data(), 1, 1);
+    cv::Mat bboxPred = convertXToBBox(x.data());
+
+    hitStreak = timeSinceUpdate > 0 ? 0 : hitStreak;
+    timeSinceUpdate++;
+
+    return bboxPred;
+}
 
-    cv::Mat xPred = kf->predict();
-    cv::Mat bboxPred = convertXToBBox(xPred);
+
+template<class Model>
+size_t KalmanBoxTrackerT<Model>::memoryUsage() const
+{
+    return sizeof(*this) + SHARED_PTR_OVERHEAD;
+}
+
+
+template<class Model>
+void KalmanBoxTrackerT<Model>::gatherPost(float* x, float* errorCov, size_t stride) const
+{
+    for (int i = 0; i < DIM_X; ++i)
+    {
+        x[i * stride] = this->x[i];
+        for (int j = 0; j < DIM_X; ++j)
+            errorCov[(i * DIM_X + j) * stride] = P[i * DIM_X + j];
+    }
+}
+
+
+template<class Model>
+cv::Mat KalmanBoxTrackerT<Model>::scatterPrior(const float* x, const float* errorCov, size_t stride)
+{
+    for (int i = 0; i < DIM_X; ++i)
+    {
+        this->x[i] = x[i * stride];
+        for (int j = 0; j < DIM_X; ++j)
+            P[i * DIM_X + j] = errorCov[(i * DIM_X + j) * stride];
+    }
+    cv::Mat bboxPred = convertXToBBox(this->x.data());
 
     hitStreak = timeSinceUpdate > 0 ? 0 : hitStreak;
     timeSinceUpdate++;
 
     return bboxPred;
-}
\ No newline at end of file
+}
+
+
+template<class Model>
+void KalmanBoxTrackerT<Model>::predictBatch(float* x, float* errorCov, size_t n, size_t stride)
+{
+    assert(stride >= n);
+    predictStates<Model>(x, errorCov, n, stride);
+}
+
+
+template class sort::KalmanBoxTrackerT<ConstantVelocityModel>;
+template class sort::KalmanBoxTrackerT<ReducedVelocityModel>;
+template class sort::KalmanBoxTrackerT<ConstantAccelerationModel>;
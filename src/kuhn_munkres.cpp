@@ -20,7 +20,8 @@ vector<pair<int, int> > KuhnMunkres::compute(const Vec2f& costMatrix) {
     this->colCovered = Vec1b(n, false);
     this->Z0_r = 0;
     this->Z0_c = 0;
-    this->path = Vec2i(n*n, Vec1i(2));
+    // an augmenting path alternates primed and starred zeros, one star per column at most
+    this->path = Vec2i(2 * n + 1, Vec1i(2));
     this->marked = KuhnMunkres::makeMatrix(n, 0);
     vector<StepFunc> steps = {
         nullptr,
@@ -49,6 +50,17 @@ vector<pair<int, int> > KuhnMunkres::compute(const Vec2f& costMatrix) {
     return result;
 }
 
+size_t KuhnMunkres::memoryUsage() const {
+    auto matrixBytes = [](const auto& matrix) {
+        size_t bytes = matrix.capacity() * sizeof(matrix[0]);
+        for (const auto& row : matrix)
+            bytes += row.capacity() * sizeof(row[0]);
+        return bytes;
+    };
+    return sizeof(*this) + matrixBytes(this->C) + matrixBytes(this->marked) + matrixBytes(this->path)
+           + (this->rowCovered.capacity() + this->colCovered.capacity()) / 8;
+}
+
 Vec2f KuhnMunkres::makeCostMatrix(const Vec2f& profixMatrix, InversionFunc func) {
     if (func == nullptr) {
         float maxinum = -__FLT_MAX__;
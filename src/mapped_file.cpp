@@ -0,0 +1,42 @@
+#include "mapped_file.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace sort;
+
+MappedFile::MappedFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+
+    length = st.st_size;
+    if (length > 0)
+    {
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("cannot mmap " + path);
+        }
+        ptr = static_cast<const uint8_t*>(addr);
+    }
+    close(fd);  // the mapping stays valid after close
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (ptr != nullptr)
+        munmap(const_cast<uint8_t*>(ptr), length);
+}
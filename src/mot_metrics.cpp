@@ -0,0 +1,155 @@
+#include "mot_metrics.h"
+#include <assert.h>
+#include <algorithm>
+#include <cfloat>
+
+using namespace sort;
+using kuhn_munkres::Vec1f;
+using kuhn_munkres::Vec2f;
+
+MotMetrics& MotMetrics::operator+=(const MotMetrics& other)
+{
+    numFrames += other.numFrames;
+    numGt += other.numGt;
+    numPred += other.numPred;
+    tp += other.tp;
+    fp += other.fp;
+    fn += other.fn;
+    idsw += other.idsw;
+    frag += other.frag;
+    idtp += other.idtp;
+    idfp += other.idfp;
+    idfn += other.idfn;
+    return *this;
+}
+
+
+MotAccumulator::MotAccumulator(float iouThresh)
+    : iouThresh(iouThresh)
+{
+}
+
+
+MotAccumulator::~MotAccumulator()
+{
+}
+
+
+void MotAccumulator::update(const cv::Mat& gtBoxes, const std::vector<int>& gtIds,
+                            const cv::Mat& predBoxes, const std::vector<int>& predIds)
+{
+    assert(gtBoxes.rows == (int)gtIds.size() && predBoxes.rows == (int)predIds.size());
+    int numG = gtBoxes.rows;
+    int numT = predBoxes.rows;
+
+    metrics.numFrames++;
+    metrics.numGt += numG;
+    metrics.numPred += numT;
+
+    // IoU of every (gt, tracker) pair, identity co-occurrences are counted on all covering pairs
+    Vec2f iouMat(numG, Vec1f(numT, 0.0f));
+    for (int i = 0; i < numG; ++i)
+        for (int j = 0; j < numT; ++j)
+        {
+            iouMat[i][j] = iou(gtBoxes.ptr<float>(i), predBoxes.ptr<float>(j));
+            if (iouMat[i][j] >= iouThresh)
+                coCount[{gtIds[i], predIds[j]}]++;
+        }
+
+    // keep the correspondences of the previous frames that are still valid
+    std::vector<int> gtMatch(numG, -1), predMatch(numT, -1);
+    for (int i = 0; i < numG; ++i)
+    {
+        auto it = lastMatch.find(gtIds[i]);
+        if (it == lastMatch.end()) continue;
+        for (int j = 0; j < numT; ++j)
+            if (predIds[j] == it->second && predMatch[j] < 0 && iouMat[i][j] >= iouThresh)
+            {
+                gtMatch[i] = j;
+                predMatch[j] = i;
+                break;
+            }
+    }
+
+    // assign the remaining boxes with minimal total distance
+    std::vector<int> freeG, freeT;
+    for (int i = 0; i < numG; ++i) if (gtMatch[i] < 0) freeG.push_back(i);
+    for (int j = 0; j < numT; ++j) if (predMatch[j] < 0) freeT.push_back(j);
+    if (!freeG.empty() && !freeT.empty())
+    {
+        Vec2f costMatrix(freeG.size(), Vec1f(freeT.size(), 1.0f));
+        for (size_t a = 0; a < freeG.size(); ++a)
+            for (size_t b = 0; b < freeT.size(); ++b)
+                if (iouMat[freeG[a]][freeT[b]] >= iouThresh)
+                    costMatrix[a][b] = 1.0f - iouMat[freeG[a]][freeT[b]];
+
+        for (auto [a, b] : km.compute(costMatrix))
+        {
+            int i = freeG[a], j = freeT[b];
+            if (iouMat[i][j] < iouThresh) continue;
+            gtMatch[i] = j;
+            predMatch[j] = i;
+
+            auto it = lastMatch.find(gtIds[i]);
+            if (it != lastMatch.end() && it->second != predIds[j])
+                metrics.idsw++;
+            lastMatch[gtIds[i]] = predIds[j];
+        }
+    }
+
+    // fragmentation: a trajectory resumed after being lost
+    for (int i = 0; i < numG; ++i)
+    {
+        bool matched = gtMatch[i] >= 0;
+        auto it = tracked.find(gtIds[i]);
+        if (matched && it != tracked.end() && !it->second)
+            metrics.frag++;
+        if (matched || it != tracked.end())
+            tracked[gtIds[i]] = matched;
+        metrics.tp += matched;
+    }
+    int numMatched = std::count_if(gtMatch.begin(), gtMatch.end(), [](int j) { return j >= 0; });
+    metrics.fn += numG - numMatched;
+    metrics.fp += numT - numMatched;
+}
+
+
+MotMetrics MotAccumulator::getMetrics()
+{
+    // one-to-one mapping of gt ids to tracker ids that maximizes the co-occurrences,
+    // ids that never overlap cannot contribute and are left out of the problem
+    std::map<int, int> gtIndex, predIndex;
+    for (const auto& [ids, count] : coCount)
+    {
+        gtIndex.emplace(ids.first, gtIndex.size());
+        predIndex.emplace(ids.second, predIndex.size());
+    }
+
+    int idtp = 0;
+    if (!coCount.empty())
+    {
+        Vec2f profitMatrix(gtIndex.size(), Vec1f(predIndex.size(), 0.0f));
+        for (const auto& [ids, count] : coCount)
+            profitMatrix[gtIndex[ids.first]][predIndex[ids.second]] = count;
+
+        Vec2f costMatrix = kuhn_munkres::KuhnMunkres::makeCostMatrix(profitMatrix);
+        for (auto [i, j] : km.compute(costMatrix))
+            idtp += profitMatrix[i][j];
+    }
+
+    MotMetrics result = metrics;
+    result.idtp = idtp;
+    result.idfn = result.numGt - idtp;
+    result.idfp = result.numPred - idtp;
+    return result;
+}
+
+
+float MotAccumulator::iou(const float* a, const float* b)
+{
+    float w = std::min(a[0] + a[2] / 2, b[0] + b[2] / 2) - std::max(a[0] - a[2] / 2, b[0] - b[2] / 2);
+    float h = std::min(a[1] + a[3] / 2, b[1] + b[3] / 2) - std::max(a[1] - a[3] / 2, b[1] - b[3] / 2);
+    if (w <= 0 || h <= 0) return 0.0f;
+    float inter = w * h;
+    return inter / (a[2] * a[3] + b[2] * b[3] - inter + FLT_EPSILON);
+}
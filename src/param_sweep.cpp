@@ -0,0 +1,146 @@
+#include "param_sweep.h"
+#include <filesystem>
+#include "sort.h"
+#include "thread_pool.h"
+
+using namespace sort;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string findDetections(const fs::path& folder, const std::string& name)
+    {
+        fs::path binary = folder / (name + ".sortdet");
+        return fs::exists(binary) ? binary.string() : (folder / (name + ".txt")).string();
+    }
+
+    /**
+     * @brief scored ground truth classes: pedestrian, or no class at all (MOT15)
+     */
+    inline bool isPedestrian(int classId)
+    {
+        return classId == 0 || classId == 1;
+    }
+
+    /**
+     * @brief person on vehicle, static person, distractor, reflection
+     */
+    inline bool isDistractor(int classId)
+    {
+        return classId == 2 || classId == 7 || classId == 8 || classId == 12;
+    }
+
+    /**
+     * @brief drop the tracker boxes covering a distractor, as the MOT devkit does: the boxes are matched
+     *        to every ground truth box of the frame, a box matched to a distractor is neither a TP nor a FP
+     * @param frameGt ground truth of the frame, Mat(G, 6) [xc, yc, w, h, consider, class_id]
+     * @param bboxesPost tracker boxes, Mat(T, 9)
+     * @param iouThresh minimal IoU of a match
+     * @return kept tracker boxes
+     */
+    cv::Mat dropDistractorMatches(const cv::Mat& frameGt, const cv::Mat& bboxesPost, float iouThresh)
+    {
+        bool anyDistractor = false;
+        for (int i = 0; i < frameGt.rows; ++i)
+            anyDistractor = anyDistractor || isDistractor(frameGt.at<float>(i, 5));
+        if (!anyDistractor || bboxesPost.rows == 0)
+            return bboxesPost;
+
+        cv::Mat iouMat = Sort::getIouMatrix(frameGt, bboxesPost);
+        kuhn_munkres::Vec2f costMatrix(iouMat.rows, kuhn_munkres::Vec1f(iouMat.cols));
+        for (int i = 0; i < iouMat.rows; ++i)
+            for (int j = 0; j < iouMat.cols; ++j)
+                costMatrix[i][j] = 1.0f - iouMat.at<float>(i, j);
+        kuhn_munkres::KuhnMunkres km;
+        std::vector<char> isDropped(bboxesPost.rows, 0);
+        for (auto [i, j] : km.compute(costMatrix))
+            if (iouMat.at<float>(i, j) >= iouThresh && isDistractor(frameGt.at<float>(i, 5)))
+                isDropped[j] = 1;
+
+        cv::Mat kept(0, bboxesPost.cols, CV_32F);
+        for (int j = 0; j < bboxesPost.rows; ++j)
+            if (!isDropped[j])
+                kept.push_back(bboxesPost.rowRange(j, j + 1));
+        return kept;
+    }
+}
+
+
+SequenceData sort::loadSequence(const std::string& dataFolder)
+{
+    fs::path folder(dataFolder);
+    SequenceData seq;
+    seq.name = folder.has_filename() ? folder.filename().string() : folder.parent_path().filename().string();
+    seq.dets = readDetections(findDetections(folder, "det/det"));
+    seq.gt = readDetections(findDetections(folder, "gt/gt"));
+    return seq;
+}
+
+
+MotMetrics sort::evaluateSequence(const SequenceData& seq, const SortParams& params, float evalIouThresh)
+{
+    Sort mot(params.maxAge, params.minHits, params.iouThresh);
+    MotAccumulator acc(evalIouThresh);
+
+    int firstFrame = std::min(seq.dets.firstFrame, seq.gt.firstFrame);
+    int lastFrame = std::max(seq.dets.firstFrame + (int)seq.dets.dets.size(),
+                             seq.gt.firstFrame + (int)seq.gt.dets.size());
+    const cv::Mat noDets(0, 6, CV_32F);
+    for (int frameId = firstFrame; frameId < lastFrame; ++frameId)
+    {
+        int k = frameId - seq.dets.firstFrame;
+        bool hasDets = k >= 0 && k < (int)seq.dets.dets.size();
+        cv::Mat bboxesPost = mot.update(hasDets ? seq.dets.dets[k] : noDets);
+
+        // pedestrians with the consider flag set are scored, as in the MOT devkit
+        cv::Mat gtBoxes(0, 6, CV_32F);
+        std::vector<int> gtIds;
+        int g = frameId - seq.gt.firstFrame;
+        if (g >= 0 && g < (int)seq.gt.dets.size())
+        {
+            const cv::Mat& frameGt = seq.gt.dets[g];
+            bboxesPost = dropDistractorMatches(frameGt, bboxesPost, evalIouThresh);
+            for (int i = 0; i < frameGt.rows; ++i)
+            {
+                if (frameGt.at<float>(i, 4) == 0 || !isPedestrian(frameGt.at<float>(i, 5))) continue;
+                gtBoxes.push_back(frameGt.rowRange(i, i + 1));
+                gtIds.push_back(seq.gt.ids[g][i]);
+            }
+        }
+
+        std::vector<int> predIds(bboxesPost.rows);
+        for (int i = 0; i < bboxesPost.rows; ++i)
+            predIds[i] = bboxesPost.at<float>(i, 8);
+
+        acc.update(gtBoxes, gtIds, bboxesPost, predIds);
+    }
+
+    return acc.getMetrics();
+}
+
+
+std::vector<SweepResult> sort::sweep(const std::vector<SortParams>& grid, const std::vector<SequenceData>& seqs,
+                                     int numThreads, float evalIouThresh)
+{
+    std::vector<SweepResult> results(grid.size());
+    for (size_t p = 0; p < grid.size(); ++p)
+    {
+        results[p].params = grid[p];
+        results[p].perSequence.resize(seqs.size());
+    }
+
+    // every job writes its own slot, the totals are summed afterwards in a fixed order
+    ThreadPool pool(numThreads);
+    int numSeqs = seqs.size();
+    pool.run(grid.size() * numSeqs, [&](int job) {
+        int p = job / numSeqs, s = job % numSeqs;
+        results[p].perSequence[s] = evaluateSequence(seqs[s], grid[p], evalIouThresh);
+    });
+
+    for (auto& result : results)
+        for (const auto& metrics : result.perSequence)
+            result.metrics += metrics;
+
+    return results;
+}
@@ -0,0 +1,502 @@
+#include "reference_check.h"
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include "det_file.h"
+
+using namespace sort;
+
+namespace
+{
+    /**
+     * @brief header and tracker records of a snapshot taken by Sort::snapshot
+     */
+    struct SnapshotView
+    {
+        SortSnapshotHeader header;
+        vector<KalmanBoxTrackerState> states;
+
+        explicit SnapshotView(const vector<uint8_t>& data)
+        {
+            memcpy(&header, data.data(), sizeof(header));
+            states.resize(header.numTrackers);
+            memcpy(states.data(), data.data() + sizeof(header), states.size() * sizeof(KalmanBoxTrackerState));
+        }
+    };
+
+    /**
+     * @brief constant model matrix, rows x cols, from a row-major array
+     */
+    inline cv::Mat modelMatrix(const float* values, int rows, int cols)
+    {
+        return cv::Mat(rows, cols, CV_32F, const_cast<float*>(values)).clone();
+    }
+
+    /**
+     * @brief bounding box [xc, yc, w, h] of a state [xc, yc, s, r, ...]
+     */
+    inline cv::Mat stateToBBox(const cv::Mat &state)
+    {
+        float w = std::sqrt(state.at<float>(2, 0) * state.at<float>(3, 0));
+        return (cv::Mat_<float>(1, 4) << state.at<float>(0, 0), state.at<float>(1, 0), w, state.at<float>(2, 0) / w);
+    }
+
+    /**
+     * @brief maximal difference of two covariances, entry (i, j) relative to max(1, sqrt(|Pp(i, i) * Pp(j, j)|))
+     *        of the predicted covariance Pp: a correction cancels out large prior variances (those of a new
+     *        tracker), which leaves the rounding of the prior on the small posterior entries
+     */
+    float covarianceDrift(const float* value, const float* expected, const cv::Mat& prior)
+    {
+        int dim = prior.rows;
+        float maxDrift = 0.0f;
+        for (int i = 0; i < dim; ++i)
+            for (int j = 0; j < dim; ++j)
+            {
+                float a = value[i * dim + j], b = expected[i * dim + j];
+                if (a != a || b != b)
+                {
+                    maxDrift = a != a && b != b ? maxDrift : FLT_MAX;
+                    continue;
+                }
+                float scale = std::sqrt(std::fabs(prior.at<float>(i, i) * prior.at<float>(j, j)));
+                maxDrift = std::max(maxDrift, std::fabs(a - b) / std::max(1.0f, scale));
+            }
+        return maxDrift;
+    }
+
+    /**
+     * @brief the count highest scoring detections of indices in ascending order, ties to the lower index,
+     *        the rule of Sort::setMaxDetections and Sort::setMaxTracks
+     */
+    vector<int> keepBestScores(const cv::Mat &bboxesDet, const vector<int> &indices, size_t count)
+    {
+        vector<int> kept = indices;
+        std::stable_sort(kept.begin(), kept.end(), [&](int a, int b) {
+            return bboxesDet.at<float>(a, 4) > bboxesDet.at<float>(b, 4);
+        });
+        kept.resize(std::min(count, kept.size()));
+        std::sort(kept.begin(), kept.end());
+        return kept;
+    }
+}
+
+
+template<class Model>
+ReferenceTrackerT<Model>::ReferenceTrackerT(const State& state)
+    : state(state), kf(DIM_X, DIM_Z)
+{
+    kf.transitionMatrix = modelMatrix(Model::F, DIM_X, DIM_X);
+    kf.measurementMatrix = modelMatrix(Model::H, DIM_Z, DIM_X);
+    kf.measurementNoiseCov = modelMatrix(Model::R, DIM_Z, DIM_Z);
+    kf.processNoiseCov = modelMatrix(Model::Q, DIM_X, DIM_X);
+    for (int i = 0; i < DIM_X; ++i)
+    {
+        kf.statePost.at<float>(i, 0) = state.statePost[i];
+        for (int j = 0; j < DIM_X; ++j)
+            kf.errorCovPost.at<float>(i, j) = state.errorCovPost[i * DIM_X + j];
+    }
+}
+
+
+template<class Model>
+ReferenceTrackerT<Model>::ReferenceTrackerT(const cv::Mat& bbox, int id)
+    : ReferenceTrackerT([&]() {
+          State init;
+          memset(&init, 0, sizeof(init));
+          init.id = id;
+          std::copy(Model::P0, Model::P0 + DIM_X * DIM_X, init.errorCovPost);
+          init.statePost[0] = bbox.at<float>(0, 0);
+          init.statePost[1] = bbox.at<float>(0, 1);
+          init.statePost[2] = bbox.at<float>(0, 2) * bbox.at<float>(0, 3);
+          init.statePost[3] = bbox.at<float>(0, 2) / bbox.at<float>(0, 3);
+          return init;
+      }())
+{
+}
+
+
+template<class Model>
+ReferenceTrackerT<Model>::~ReferenceTrackerT()
+{
+}
+
+
+template<class Model>
+void ReferenceTrackerT<Model>::exportState(State& state) const
+{
+    state = this->state;
+    for (int i = 0; i < DIM_X; ++i)
+    {
+        state.statePost[i] = kf.statePost.at<float>(i, 0);
+        for (int j = 0; j < DIM_X; ++j)
+            state.errorCovPost[i * DIM_X + j] = kf.errorCovPost.at<float>(i, j);
+    }
+}
+
+
+template<class Model>
+cv::Mat ReferenceTrackerT<Model>::predict()
+{
+    // bbox area (ds/dt + s) shouldn't be negtive
+    if constexpr (Model::VS >= 0)
+        if (kf.statePost.at<float>(Model::VS, 0) + kf.statePost.at<float>(2, 0) <= 0)
+            kf.statePost.at<float>(Model::VS, 0) *= 0;
+
+    cv::Mat bboxPred = stateToBBox(kf.predict());
+    state.hitStreak = state.timeSinceUpdate > 0 ? 0 : state.hitStreak;
+    state.timeSinceUpdate++;
+    return bboxPred;
+}
+
+
+template<class Model>
+cv::Mat ReferenceTrackerT<Model>::update(const cv::Mat& bbox)
+{
+    state.timeSinceUpdate = 0;
+    state.hitStreak += 1;
+    state.hasPost = 1;
+    cv::Mat z = (cv::Mat_<float>(DIM_Z, 1) << bbox.at<float>(0, 0), bbox.at<float>(0, 1),
+                 bbox.at<float>(0, 2) * bbox.at<float>(0, 3), bbox.at<float>(0, 2) / bbox.at<float>(0, 3));
+    return stateToBBox(kf.correct(z));
+}
+
+
+template class sort::ReferenceTrackerT<ConstantVelocityModel>;
+template class sort::ReferenceTrackerT<ReducedVelocityModel>;
+template class sort::ReferenceTrackerT<ConstantAccelerationModel>;
+
+
+ReferenceCheck::ReferenceCheck(Sort::Ptr fast, float tolerance, const std::string& dumpDir)
+    : fast(fast), tolerance(tolerance), dumpDir(dumpDir)
+{
+    assert(fast != nullptr);
+    solver = make_shared<AssociationSolver>();
+    restoreReference(fast->snapshot());
+}
+
+
+ReferenceCheck::~ReferenceCheck()
+{
+}
+
+
+cv::Mat ReferenceCheck::update(const cv::Mat &bboxesDet)
+{
+    cv::Mat fastOutput = fast->update(bboxesDet);
+    check(bboxesDet, fastOutput);
+    return fastOutput;
+}
+
+
+bool ReferenceCheck::check(const cv::Mat &bboxesDet, const cv::Mat &fastOutput)
+{
+    vector<uint8_t> before = dumpDir.empty() ? vector<uint8_t>() : snapshotReference();
+    ReferenceCheckReport report;
+    cv::Mat referenceOutput = updateReference(bboxesDet, report);
+    numChecked++;
+
+    vector<uint8_t> fastSnapshot = fast->snapshot();
+    SnapshotView cur(fastSnapshot);
+    report.frame = referenceHeader.frameCount;
+    report.numTrackers[0] = referenceTrackers.size();
+    report.numTrackers[1] = cur.states.size();
+    report.numTracks[0] = referenceOutput.rows;
+    report.numTracks[1] = fastOutput.rows;
+
+    // reported tracks, row by row since both follow the detection order
+    if (report.numTracks[0] == report.numTracks[1])
+    {
+        for (int i = 0; i < referenceOutput.rows; ++i)
+        {
+            for (int c = 0; c < 8; ++c)
+                report.outputDrift = std::max(report.outputDrift,
+                                              drift(fastOutput.at<float>(i, c), referenceOutput.at<float>(i, c)));
+            if (!matchIds(fastOutput.at<float>(i, 8), referenceOutput.at<float>(i, 8)))
+                report.numIdMismatches++;
+        }
+    }
+
+    // trackers, in order since both create and remove them in the same order
+    if (report.numTrackers[0] == report.numTrackers[1])
+    {
+        KalmanBoxTrackerState b;
+        for (size_t t = 0; t < referenceTrackers.size(); ++t)
+        {
+            const KalmanBoxTrackerState& a = cur.states[t];
+            referenceTrackers[t]->exportState(b);
+            if (!matchIds(a.id, b.id))
+                report.numIdMismatches++;
+            if (a.timeSinceUpdate != b.timeSinceUpdate || a.hitStreak != b.hitStreak || a.hasPost != b.hasPost ||
+                a.confirmed != b.confirmed)
+                report.stateDrift = FLT_MAX;
+            for (int k = 0; k < KalmanBoxTracker::DIM_X; ++k)
+                report.stateDrift = std::max(report.stateDrift, drift(a.statePost[k], b.statePost[k]));
+            report.stateDrift = std::max(report.stateDrift,
+                                         covarianceDrift(a.errorCovPost, b.errorCovPost,
+                                                         referenceTrackers[t]->getErrorCovPrior()));
+        }
+    }
+
+    bool isEqual = report.numTracks[0] == report.numTracks[1] && report.numTrackers[0] == report.numTrackers[1] &&
+                   report.outputDrift <= tolerance && report.stateDrift <= tolerance && report.numIdMismatches == 0 &&
+                   report.assignmentGap <= tolerance * std::max(1, std::min(report.numTrackers[0], bboxesDet.rows));
+
+    // the next frame starts from the fast tracker, ids included, so the rounding of the two filters does
+    // not accumulate
+    restoreReference(fastSnapshot);
+    idMap.clear();
+    idMapBack.clear();
+    if (isEqual) return true;
+
+    if (!dumpDir.empty())
+        report.reproducer = dump(report.frame, before, bboxesDet);
+    reports.push_back(report);
+    return false;
+}
+
+
+cv::Mat ReferenceCheck::updateReference(const cv::Mat &bboxesDetIn, ReferenceCheckReport& report)
+{
+    SortSnapshotHeader& header = referenceHeader;
+    header.frameCount++;
+
+    // predict, the trackers with an invalid prediction are removed
+    cv::Mat bboxesPred(referenceTrackers.size(), 4, CV_32F, cv::Scalar(0));
+    int numPreds = 0;
+    for (size_t t = 0; t < referenceTrackers.size(); ++t)
+    {
+        cv::Mat bboxPred = referenceTrackers[t]->predict();
+        bool isNan = false;
+        for (int c = 0; c < 4; ++c)
+            isNan |= bboxPred.at<float>(0, c) != bboxPred.at<float>(0, c);
+        if (isNan) continue;
+        for (int c = 0; c < 4; ++c)
+            bboxesPred.at<float>(numPreds, c) = bboxPred.at<float>(0, c);
+        referenceTrackers[numPreds++] = referenceTrackers[t];
+    }
+    referenceTrackers.resize(numPreds);
+    bboxesPred = bboxesPred.rowRange(0, numPreds);
+
+    // the highest scoring detections within maxDetections
+    cv::Mat bboxesDet = bboxesDetIn;
+    if (header.maxDetections > 0 && bboxesDetIn.rows > header.maxDetections)
+    {
+        vector<int> rows(bboxesDetIn.rows);
+        std::iota(rows.begin(), rows.end(), 0);
+        vector<int> kept = keepBestScores(bboxesDetIn, rows, header.maxDetections);
+        bboxesDet = cv::Mat(kept.size(), bboxesDetIn.cols, CV_32F);
+        for (size_t k = 0; k < kept.size(); ++k)
+            for (int c = 0; c < bboxesDetIn.cols; ++c)
+                bboxesDet.at<float>(k, c) = bboxesDetIn.at<float>(kept[k], c);
+    }
+    int numDets = bboxesDet.rows;
+
+    // assignment maximizing the total IoU, pairs overlapping less than iouThresh stay unmatched
+    TypeMatchedPairs matched;
+    vector<char> isDetMatched(numDets, 0);
+    if (numDets > 0 && numPreds > 0)
+    {
+        cv::Mat iouMat = Sort::getIouMatrix(bboxesDet, bboxesPred);
+        report.assignmentGap = solverGap(iouMat);
+
+        TypeMatchedPairs pairs;
+        if (header.maxSolverDimension > 0)
+        {
+            // a bounded solver is inexact by design, the reference sheds the same work with the same solver
+            solver->setAdaptive(header.adaptiveSolver != 0);
+            solver->setMaxDimension(header.maxSolverDimension);
+            pairs = solver->solve(iouMat, header.iouThresh > 0);
+        }
+        else
+        {
+            Vec2f costMatrix(numDets, Vec1f(numPreds));
+            for (int i = 0; i < numDets; ++i)
+                for (int j = 0; j < numPreds; ++j)
+                    costMatrix[i][j] = 1.0f - iouMat.at<float>(i, j);
+            pairs = km.compute(costMatrix);
+            std::sort(pairs.begin(), pairs.end());
+        }
+        for (auto [detInd, predInd] : pairs)
+        {
+            if (iouMat.at<float>(detInd, predInd) < header.iouThresh)
+                continue;
+            matched.push_back({detInd, predInd});
+            isDetMatched[detInd] = 1;
+        }
+    }
+
+    // update the matched trackers, the confirmed ones are reported in matched order
+    vector<std::array<float, 9> > rows;
+    for (auto [detInd, predInd] : matched)
+    {
+        ReferenceTracker& kbt = *referenceTrackers[predInd];
+        cv::Mat bboxPost = kbt.update(bboxesDet.rowRange(detInd, detInd + 1));
+        if (kbt.getHitStreak() < header.minHits)
+            continue;
+        kbt.setConfirmed();
+        rows.push_back({bboxPost.at<float>(0, 0), bboxPost.at<float>(0, 1), bboxPost.at<float>(0, 2),
+                        bboxPost.at<float>(0, 3), bboxesDet.at<float>(detInd, 4),
+                        float(int(bboxesDet.at<float>(detInd, 5))), kbt.getStatePost(ConstantVelocityModel::VX),
+                        kbt.getStatePost(ConstantVelocityModel::VY), float(kbt.getFilterId())});
+    }
+    cv::Mat bboxesPost(rows.size(), 9, CV_32F, cv::Scalar(0));
+    for (size_t k = 0; k < rows.size(); ++k)
+        for (int c = 0; c < 9; ++c)
+            bboxesPost.at<float>(k, c) = rows[k][c];
+
+    // remove dead trackers, keeping the order of the others
+    size_t numAlive = 0;
+    for (size_t t = 0; t < referenceTrackers.size(); ++t)
+        if (referenceTrackers[t]->getTimeSinceUpdate() <= header.maxAge)
+            referenceTrackers[numAlive++] = referenceTrackers[t];
+    referenceTrackers.resize(numAlive);
+
+    // new trackers for the unmatched detections, the highest scoring ones within maxTracks
+    vector<int> lostDets;
+    for (int i = 0; i < numDets; ++i)
+        if (!isDetMatched[i]) lostDets.push_back(i);
+    if (header.maxTracks > 0 && referenceTrackers.size() + lostDets.size() > size_t(header.maxTracks))
+    {
+        size_t room = referenceTrackers.size() < size_t(header.maxTracks) ? header.maxTracks - referenceTrackers.size() : 0;
+        lostDets = keepBestScores(bboxesDet, lostDets, room);
+    }
+    for (int lostInd : lostDets)
+        referenceTrackers.push_back(make_shared<ReferenceTracker>(bboxesDet.rowRange(lostInd, lostInd + 1),
+                                                                  header.filterCount++));
+
+    return bboxesPost;
+}
+
+
+vector<uint8_t> ReferenceCheck::snapshotReference() const
+{
+    SortSnapshotHeader header = referenceHeader;
+    header.numTrackers = referenceTrackers.size();
+    vector<uint8_t> data(sizeof(header) + referenceTrackers.size() * sizeof(KalmanBoxTrackerState));
+    memcpy(data.data(), &header, sizeof(header));
+
+    KalmanBoxTrackerState state;
+    uint8_t* record = data.data() + sizeof(header);
+    for (const auto& kbt : referenceTrackers)
+    {
+        kbt->exportState(state);
+        memcpy(record, &state, sizeof(state));
+        record += sizeof(state);
+    }
+    return data;
+}
+
+
+void ReferenceCheck::restoreReference(const vector<uint8_t>& snapshot)
+{
+    SnapshotView view(snapshot);
+    referenceHeader = view.header;
+    referenceTrackers.clear();
+    for (const auto& state : view.states)
+        referenceTrackers.push_back(make_shared<ReferenceTracker>(state));
+}
+
+
+float ReferenceCheck::solverGap(const cv::Mat &iouMat)
+{
+    // the negated IoU, zero IoU pairs left out by the fast strategy cost nothing
+    Vec2f costMatrix(iouMat.rows, Vec1f(iouMat.cols));
+    for (int i = 0; i < iouMat.rows; ++i)
+        for (int j = 0; j < iouMat.cols; ++j)
+            costMatrix[i][j] = -iouMat.at<float>(i, j);
+
+    solver->setAdaptive(fast->isAdaptiveSolver());
+    solver->setMaxDimension(0);
+    return assignmentCostGap(costMatrix, solver->solve(iouMat));
+}
+
+
+bool ReferenceCheck::matchIds(int fastId, int referenceId)
+{
+    auto it = idMap.find(fastId);
+    if (it != idMap.end())
+        return it->second == referenceId;
+    if (idMapBack.count(referenceId))
+        return false;
+    idMap[fastId] = referenceId;
+    idMapBack[referenceId] = fastId;
+    return true;
+}
+
+
+std::string ReferenceCheck::dump(int frame, const vector<uint8_t>& snapshot, const cv::Mat &bboxesDet) const
+{
+    std::string prefix = dumpDir + "/frame_" + std::to_string(frame);
+
+    std::ofstream ofs(prefix + ".sortsnap", std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size());
+    if (!ofs)
+        throw std::runtime_error("cannot write " + prefix + ".sortsnap");
+
+    DetSequence seq;
+    seq.firstFrame = frame;
+    seq.dets.push_back(bboxesDet);
+    writeDetFile(prefix + ".sortdet", seq);
+    return prefix;
+}
+
+
+float ReferenceCheck::assignmentCostGap(const Vec2f& costMatrix, const TypeMatchedPairs& pairs)
+{
+    if (costMatrix.empty() || costMatrix[0].empty()) return 0.0f;
+
+    KuhnMunkres km;
+    float optimum = 0.0f, cost = 0.0f;
+    for (auto [i, j] : km.compute(costMatrix))
+        optimum += costMatrix[i][j];
+    for (auto [i, j] : pairs)
+        cost += costMatrix[i][j];
+    return cost - optimum;
+}
+
+
+template<class Model>
+float ReferenceCheck::motionModelDrift(int numFrames, unsigned seed)
+{
+    using State = KalmanBoxTrackerStateT<Model>;
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+    std::uniform_int_distribution<int> miss(0, 4);
+
+    // a box moving at constant speed with noisy detections, one frame in five missed on average. the
+    // reference restarts from the unrolled state every frame, as ReferenceCheck after a divergence: the
+    // standard form of the filter lets float rounding grow over a long track in both, which is not a
+    // difference of the two
+    cv::Mat bbox = (cv::Mat_<float>(1, 4) << 200, 150, 40, 80);
+    KalmanBoxTrackerT<Model> unrolled(bbox, 0);
+    float maxDrift = 0.0f;
+    State a, b;
+    for (int f = 1; f <= numFrames; ++f)
+    {
+        unrolled.exportState(a);
+        ReferenceTrackerT<Model> reference(a);
+        unrolled.predict();
+        reference.predict();
+        if (miss(rng) > 0)
+        {
+            cv::Mat det = (cv::Mat_<float>(1, 4) << 200 + 3.0f * f + noise(rng), 150 - 1.5f * f + noise(rng),
+                           40 + 0.2f * noise(rng), 80 + 0.4f * noise(rng));
+            unrolled.update(det);
+            reference.update(det);
+        }
+        unrolled.exportState(a);
+        reference.exportState(b);
+        for (int k = 0; k < Model::DIM_X; ++k)
+            maxDrift = std::max(maxDrift, drift(a.statePost[k], b.statePost[k]));
+        maxDrift = std::max(maxDrift, covarianceDrift(a.errorCovPost, b.errorCovPost, reference.getErrorCovPrior()));
+    }
+    return maxDrift;
+}
+
+
+template float ReferenceCheck::motionModelDrift<ConstantVelocityModel>(int, unsigned);
+template float ReferenceCheck::motionModelDrift<ReducedVelocityModel>(int, unsigned);
+template float ReferenceCheck::motionModelDrift<ConstantAccelerationModel>(int, unsigned);
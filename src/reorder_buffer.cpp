@@ -0,0 +1,120 @@
+#include "reorder_buffer.h"
+
+using namespace sort;
+
+ReorderBuffer::ReorderBuffer(Sort::Ptr mot, int window, std::chrono::milliseconds deadline, int firstFrame)
+    : mot(mot), window(window > 0 ? window : 1), deadline(deadline), nextFrame(firstFrame)
+{
+    assert(mot != nullptr);
+}
+
+
+ReorderBuffer::~ReorderBuffer()
+{
+}
+
+
+bool ReorderBuffer::push(int frameIndex, const cv::Mat &bboxesDet)
+{
+    assert(bboxesDet.rows >= 0 && bboxesDet.cols == 6); // detections, [xc, yc, w, h, score, class_id]
+    std::unique_lock<std::mutex> lock(mtx);
+
+    // too far ahead, wait for the window to move. the wait counts towards the deadline of the
+    // missing frames, so the consumer coasts them if they do not show up in time
+    if (!closed && frameIndex >= nextFrame + window)
+    {
+        auto it = waiting.emplace(frameIndex, Clock::now());
+        arrived.notify_all();
+        advanced.wait(lock, [&] { return closed || frameIndex < nextFrame + window; });
+        waiting.erase(it);
+    }
+
+    if (closed || frameIndex < nextFrame || pending.count(frameIndex))
+    {
+        numLate++;
+        arrived.notify_all();
+        return false;
+    }
+
+    pending.emplace(frameIndex, Pending{bboxesDet, Clock::now()});
+    arrived.notify_all();
+    return true;
+}
+
+
+bool ReorderBuffer::pop(ReorderedFrame& frame)
+{
+    cv::Mat dets;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true)
+        {
+            if (!pending.empty() && pending.begin()->first == nextFrame)
+            {
+                dets = pending.begin()->second.dets;
+                pending.erase(pending.begin());
+                frame.coasted = false;
+                break;
+            }
+
+            if (pending.empty() && waiting.empty())
+            {
+                // nothing to wait for, an idle stream is not coasted
+                if (closed) return false;
+                arrived.wait(lock);
+                continue;
+            }
+
+            // the next frame is being pushed by a producer released from the window wait
+            if (!waiting.empty() && waiting.begin()->first == nextFrame)
+            {
+                arrived.wait(lock);
+                continue;
+            }
+
+            // the next frame is missing while later ones are waiting
+            Clock::time_point expiry = Clock::time_point::max();
+            for (const auto& item : pending)
+                expiry = std::min(expiry, item.second.arrival + deadline);
+            for (const auto& item : waiting)
+                expiry = std::min(expiry, item.second + deadline);
+            if (closed || Clock::now() >= expiry)
+            {
+                dets = cv::Mat(0, 6, CV_32F);
+                frame.coasted = true;
+                numCoasted++;
+                break;
+            }
+            arrived.wait_until(lock, expiry);
+        }
+
+        frame.frameIndex = nextFrame++;
+    }
+    advanced.notify_all();
+
+    frame.tracks = mot->update(dets);
+    return true;
+}
+
+
+void ReorderBuffer::close()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    closed = true;
+    arrived.notify_all();
+    advanced.notify_all();
+}
+
+
+size_t ReorderBuffer::getNumLate()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return numLate;
+}
+
+
+size_t ReorderBuffer::getNumCoasted()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return numCoasted;
+}
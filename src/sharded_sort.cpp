@@ -0,0 +1,258 @@
+#include "sharded_sort.h"
+#include <algorithm>
+#include <numeric>
+#include <unordered_set>
+
+using namespace sort;
+
+ShardedSort::ShardedSort(cv::Size imageSize, int tileCols, int tileRows, int margin,
+                         int maxAge, int minHits, float iouThresh, int numThreads)
+    : handoffIou(iouThresh)
+{
+    assert(tileCols > 0 && tileRows > 0 && margin >= 0);
+    for (int r = 0; r < tileRows; ++r)
+    {
+        for (int c = 0; c < tileCols; ++c)
+        {
+            float x0 = float(imageSize.width) * c / tileCols;
+            float y0 = float(imageSize.height) * r / tileRows;
+            float x1 = float(imageSize.width) * (c + 1) / tileCols;
+            float y1 = float(imageSize.height) * (r + 1) / tileRows;
+            cores.push_back(cv::Rect2f(x0, y0, x1 - x0, y1 - y0));
+            regions.push_back(cv::Rect2f(x0 - margin, y0 - margin, x1 - x0 + 2 * margin, y1 - y0 + 2 * margin));
+            shards.push_back(make_shared<Sort>(maxAge, minHits, iouThresh));
+        }
+    }
+
+    if (numThreads != 1 && shards.size() > 1)
+        threadPool = make_shared<ThreadPool>(numThreads);
+}
+
+
+ShardedSort::~ShardedSort()
+{
+}
+
+
+cv::Mat ShardedSort::update(const cv::Mat &bboxesDet)
+{
+    assert(bboxesDet.rows >= 0 && bboxesDet.cols == 6); // detections, [xc, yc, w, h, score, class_id]
+    int numTiles = shards.size();
+    frameCount++;
+
+    // route every detection to the tiles whose extended region contains its center
+    vector<cv::Mat> tileDets(numTiles);
+    for (int t = 0; t < numTiles; ++t)
+        tileDets[t] = cv::Mat(0, 6, CV_32F);
+    for (int i = 0; i < bboxesDet.rows; ++i)
+    {
+        float x = bboxesDet.at<float>(i, 0);
+        float y = bboxesDet.at<float>(i, 1);
+        int core = findCore(x, y);
+        for (int t = 0; t < numTiles; ++t)
+        {
+            const cv::Rect2f& re = regions[t];
+            if (t == core || (x >= re.x && x < re.x + re.width && y >= re.y && y < re.y + re.height))
+                tileDets[t].push_back(bboxesDet.rowRange(i, i + 1));
+        }
+    }
+
+    // track every tile independently
+    vector<cv::Mat> tileOutputs(numTiles);
+    auto track = [&](int t) { tileOutputs[t] = shards[t]->update(tileDets[t]); };
+    if (threadPool != nullptr)
+        threadPool->run(numTiles, track);
+    else
+        for (int t = 0; t < numTiles; ++t) track(t);
+
+    // a tile reports the tracks centered in its core, the others are only used for the handoff
+    cv::Mat owned(0, 9, CV_32F), others(0, 9, CV_32F);
+    vector<int> ownedTiles;
+    for (int t = 0; t < numTiles; ++t)
+    {
+        const cv::Mat& output = tileOutputs[t];
+        for (int i = 0; i < output.rows; ++i)
+        {
+            bool isOwner = findCore(output.at<float>(i, 0), output.at<float>(i, 1)) == t;
+            (isOwner ? owned : others).push_back(output.rowRange(i, i + 1));
+            if (isOwner) ownedTiles.push_back(t);
+        }
+    }
+
+    vector<pair<int, int> > dropped = suppressDuplicates(owned, ownedTiles);
+    reconcile(owned, others);
+    for (auto [trackerId, kept] : dropped)
+        globalIds[trackerId] = owned.at<float>(kept, 8);
+    adoptMarginTracks(owned, others);
+
+    // forget the trackers deleted by their shard, a live tracker may stay unreported for many frames
+    std::unordered_set<int> alive;
+    for (const auto& shard : shards)
+        for (int trackerId : shard->getTrackerIds())
+            alive.insert(trackerId);
+    for (auto it = globalIds.begin(); it != globalIds.end();)
+        it = alive.count(it->first) ? std::next(it) : globalIds.erase(it);
+
+    lastOutput = owned;
+    return owned.clone();
+}
+
+
+int ShardedSort::findCore(float x, float y) const
+{
+    int best = 0;
+    float bestDist = FLT_MAX;
+    for (int t = 0; t < (int)cores.size(); ++t)
+    {
+        const cv::Rect2f& re = cores[t];
+        float dx = std::max(std::max(re.x - x, x - (re.x + re.width)), 0.0f);
+        float dy = std::max(std::max(re.y - y, y - (re.y + re.height)), 0.0f);
+        bool inside = x >= re.x && x < re.x + re.width && y >= re.y && y < re.y + re.height;
+        if (inside) return t;
+        if (dx * dx + dy * dy < bestDist)
+        {
+            bestDist = dx * dx + dy * dy;
+            best = t;
+        }
+    }
+    return best;
+}
+
+
+vector<pair<int, int> > ShardedSort::suppressDuplicates(cv::Mat& owned, vector<int>& ownedTiles)
+{
+    vector<pair<int, int> > dropped;
+    if (owned.rows < 2) return dropped;
+
+    // rows already mapped to a global id are kept first, then the most confident ones
+    vector<int> order(owned.rows);
+    std::iota(order.begin(), order.end(), 0);
+    auto isMapped = [&](int i) { return globalIds.count(int(owned.at<float>(i, 8))) > 0; };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        if (isMapped(a) != isMapped(b)) return isMapped(a);
+        return owned.at<float>(a, 4) > owned.at<float>(b, 4);
+    });
+
+    cv::Mat iouMat = Sort::getIouMatrix(owned, owned);
+    vector<int> keptBy(owned.rows, -1);     // row kept in place of a dropped row
+    vector<int> kept;
+    for (int i : order)
+    {
+        for (int k : kept)
+            if (ownedTiles[k] != ownedTiles[i] && iouMat.at<float>(i, k) >= DUPLICATE_IOU)
+            {
+                keptBy[i] = k;
+                break;
+            }
+        if (keptBy[i] < 0) kept.push_back(i);
+    }
+    if (kept.size() == size_t(owned.rows)) return dropped;
+
+    // compact, keeping the row order
+    vector<int> newIndex(owned.rows, -1);
+    cv::Mat compact(0, 9, CV_32F);
+    vector<int> compactTiles;
+    for (int i = 0; i < owned.rows; ++i)
+        if (keptBy[i] < 0)
+        {
+            newIndex[i] = compact.rows;
+            compact.push_back(owned.rowRange(i, i + 1));
+            compactTiles.push_back(ownedTiles[i]);
+        }
+    for (int i = 0; i < owned.rows; ++i)
+        if (keptBy[i] >= 0)
+            dropped.push_back({int(owned.at<float>(i, 8)), newIndex[keptBy[i]]});
+    owned = compact;
+    ownedTiles = compactTiles;
+    return dropped;
+}
+
+
+void ShardedSort::adoptMarginTracks(const cv::Mat& owned, const cv::Mat& others)
+{
+    vector<int> orphans;
+    for (int i = 0; i < others.rows; ++i)
+        if (!globalIds.count(int(others.at<float>(i, 8))))
+            orphans.push_back(i);
+    if (orphans.empty() || owned.rows == 0) return;
+
+    cv::Mat iouMat = Sort::getIouMatrix(others, owned);
+    for (int i : orphans)
+    {
+        int best = -1;
+        for (int j = 0; j < owned.rows; ++j)
+            if (iouMat.at<float>(i, j) >= handoffIou && (best < 0 || iouMat.at<float>(i, j) > iouMat.at<float>(i, best)))
+                best = j;
+        if (best >= 0)
+            globalIds[int(others.at<float>(i, 8))] = owned.at<float>(best, 8);
+    }
+}
+
+
+void ShardedSort::reconcile(cv::Mat& owned, const cv::Mat& others)
+{
+    std::unordered_set<int> claimed;
+    vector<int> unresolved;
+
+    // tracks that already have a global id keep it
+    for (int i = 0; i < owned.rows; ++i)
+    {
+        auto it = globalIds.find(int(owned.at<float>(i, 8)));
+        if (it != globalIds.end() && claimed.insert(it->second).second)
+            owned.at<float>(i, 8) = it->second;
+        else
+            unresolved.push_back(i);
+    }
+    if (unresolved.empty()) return;
+
+    // handoff candidates: last reported tracks and the margin tracks of the other tiles
+    cv::Mat candidates(0, 9, CV_32F);
+    for (int i = 0; i < lastOutput.rows; ++i)
+        if (!claimed.count(int(lastOutput.at<float>(i, 8))))
+            candidates.push_back(lastOutput.rowRange(i, i + 1));
+    for (int i = 0; i < others.rows; ++i)
+    {
+        auto it = globalIds.find(int(others.at<float>(i, 8)));
+        if (it == globalIds.end() || claimed.count(it->second)) continue;
+        cv::Mat row = others.rowRange(i, i + 1).clone();
+        row.at<float>(0, 8) = it->second;
+        candidates.push_back(row);
+    }
+
+    // greedy handoff by decreasing IoU, ties resolved by row order
+    cv::Mat rows(0, 9, CV_32F);
+    for (int i : unresolved)
+        rows.push_back(owned.rowRange(i, i + 1));
+    vector<std::tuple<float, int, int> > pairs;
+    if (candidates.rows > 0)
+    {
+        cv::Mat iouMat = Sort::getIouMatrix(rows, candidates);
+        for (int a = 0; a < iouMat.rows; ++a)
+            for (int b = 0; b < iouMat.cols; ++b)
+                if (iouMat.at<float>(a, b) >= handoffIou)
+                    pairs.push_back(make_tuple(-iouMat.at<float>(a, b), a, b));
+        std::sort(pairs.begin(), pairs.end());
+    }
+
+    vector<int> inherited(unresolved.size(), -1);
+    for (auto [negIou, a, b] : pairs)
+    {
+        int globalId = candidates.at<float>(b, 8);
+        if (inherited[a] >= 0 || claimed.count(globalId)) continue;
+        inherited[a] = globalId;
+        claimed.insert(globalId);
+    }
+
+    // new objects keep their shard tracker id, which is unique across shards
+    for (size_t a = 0; a < unresolved.size(); ++a)
+    {
+        int i = unresolved[a];
+        int trackerId = owned.at<float>(i, 8);
+        int globalId = inherited[a];
+        if (globalId < 0)
+            globalId = claimed.count(trackerId) ? KalmanBoxTracker::takeFilterId() : trackerId;
+        claimed.insert(globalId);
+        globalIds[trackerId] = globalId;
+        owned.at<float>(i, 8) = globalId;
+    }
+}
@@ -0,0 +1,295 @@
+#include "shm_transport.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+using namespace sort;
+
+namespace
+{
+    constexpr int DET_COLS = sizeof(ShmDetection) / sizeof(float);
+    constexpr int TRACK_COLS = sizeof(ShmTrack) / sizeof(float);
+
+    static_assert(DET_COLS == 6 && TRACK_COLS == 9, "records follow the rows of Sort::update");
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the futex word is the atomic itself");
+
+    inline long futex(std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout)
+    {
+        // not FUTEX_PRIVATE_FLAG, the word is shared across processes
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+    }
+
+    inline size_t slotSize(int maxDets)
+    {
+        return (sizeof(ShmSlotHeader) + maxDets * sizeof(ShmTrack) + 63) / 64 * 64;
+    }
+
+    template<typename _Tp>
+    inline _Tp* records(ShmSlotHeader* slot)
+    {
+        return reinterpret_cast<_Tp*>(slot + 1);
+    }
+}
+
+
+void ShmSignal::notify()
+{
+    sequence.fetch_add(1);
+    if (numWaiting.load() > 0)
+        futex(&sequence, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+
+void ShmSignal::sleep(uint32_t seq, std::chrono::microseconds timeout)
+{
+    timespec ts;
+    ts.tv_sec = timeout.count() / 1000000;
+    ts.tv_nsec = timeout.count() % 1000000 * 1000;
+    futex(&sequence, FUTEX_WAIT, seq, &ts);     // returns at once if sequence moved since seq was read
+}
+
+
+ShmSegment::ShmSegment(const std::string& name, int numChannels, int numSlots, int maxDets)
+    : name(name), owner(numChannels > 0)
+{
+    int fd;
+    if (owner)
+    {
+        assert(numSlots > 0 && maxDets > 0);
+        // a fresh object, workers of a crashed server keep their stale mapping
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throw std::runtime_error("cannot create " + name);
+        length = slotsOffset(numChannels) + size_t(numChannels) * 2 * numSlots * slotSize(maxDets);
+        if (ftruncate(fd, length) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw std::runtime_error("cannot resize " + name);
+        }
+    }
+    else
+    {
+        fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            throw std::runtime_error("cannot open " + name);
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("cannot stat " + name);
+        }
+        length = st.st_size;
+    }
+
+    void* addr = length >= sizeof(ShmHeader) ? mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        if (owner) shm_unlink(name.c_str());
+        throw std::runtime_error("cannot mmap " + name);
+    }
+    ptr = static_cast<uint8_t*>(addr);
+
+    if (owner)
+    {
+        ShmHeader* h = new (ptr) ShmHeader();
+        memcpy(h->magic, SHM_TRANSPORT_MAGIC, sizeof(SHM_TRANSPORT_MAGIC));
+        h->version = SHM_TRANSPORT_VERSION;
+        h->numChannels = numChannels;
+        h->numSlots = numSlots;
+        h->maxDets = maxDets;
+        h->slotSize = slotSize(maxDets);
+        for (int c = 0; c < numChannels; ++c)
+            new (channel(c)) ShmChannel();
+        h->ready.store(1, std::memory_order_release);
+        return;
+    }
+
+    const ShmHeader* h = header();
+    if (memcmp(h->magic, SHM_TRANSPORT_MAGIC, sizeof(SHM_TRANSPORT_MAGIC)) != 0 ||
+        h->version != SHM_TRANSPORT_VERSION || h->ready.load(std::memory_order_acquire) != 1 ||
+        length < slotsOffset(h->numChannels) + size_t(h->numChannels) * 2 * h->numSlots * h->slotSize)
+    {
+        munmap(ptr, length);
+        throw std::runtime_error("not a tracker transport " + name);
+    }
+}
+
+
+ShmSegment::~ShmSegment()
+{
+    if (ptr != nullptr)
+        munmap(ptr, length);
+    if (owner)
+        shm_unlink(name.c_str());
+}
+
+
+ShmServer::ShmServer(const std::string& name, int numChannels, int numSlots, int maxDets,
+                     int maxAge, int minHits, float iouThresh)
+    : segment(name, numChannels, numSlots, maxDets), maxAge(maxAge), minHits(minHits), iouThresh(iouThresh)
+{
+    for (int c = 0; c < numChannels; ++c)
+        trackers.push_back(make_shared<Sort>(maxAge, minHits, iouThresh));
+    sessions.assign(numChannels, 0);
+}
+
+
+ShmServer::~ShmServer()
+{
+}
+
+
+int ShmServer::serve(std::chrono::microseconds timeout)
+{
+    ShmHeader* header = segment.header();
+    int numChannels = header->numChannels;
+    uint32_t numSlots = header->numSlots;
+
+    // a channel is ready when it has a request and room for the response
+    auto isReady = [&](int c) {
+        ShmChannel* ch = segment.channel(c);
+        return ch->requests.head.load(std::memory_order_relaxed) != ch->requests.tail.load(std::memory_order_acquire) &&
+               ch->responses.tail.load(std::memory_order_relaxed) - ch->responses.head.load(std::memory_order_acquire) < numSlots;
+    };
+    auto anyReady = [&]() {
+        for (int c = 0; c < numChannels; ++c)
+            if (isReady(c)) return true;
+        return false;
+    };
+    if (!header->doorbell.wait(anyReady, timeout))
+        return 0;
+
+    int served = 0;
+    for (int c = 0; c < numChannels; ++c)
+    {
+        ShmChannel* ch = segment.channel(c);
+        while (isReady(c))
+        {
+            uint32_t head = ch->requests.head.load(std::memory_order_relaxed);
+            uint32_t tail = ch->responses.tail.load(std::memory_order_relaxed);
+            ShmSlotHeader* request = segment.slot(c, false, head);
+            ShmSlotHeader* response = segment.slot(c, true, tail);
+
+            // a new worker starts from an empty tracker
+            if (request->session != sessions[c])
+            {
+                trackers[c] = make_shared<Sort>(maxAge, minHits, iouThresh);
+                sessions[c] = request->session;
+            }
+
+            // track on the request slot in place
+            int count = std::min(request->count, header->maxDets);
+            cv::Mat dets(count, DET_COLS, CV_32F, records<ShmDetection>(request));
+            cv::Mat tracks = trackers[c]->update(dets);
+
+            // tracks never outnumber the detections, they fit in the slot
+            response->frameIndex = request->frameIndex;
+            response->count = tracks.rows;
+            response->session = request->session;
+            if (tracks.rows > 0)
+                memcpy(records<ShmTrack>(response), tracks.ptr<float>(), tracks.rows * sizeof(ShmTrack));
+
+            ch->requests.head.store(head + 1, std::memory_order_release);
+            ch->responses.tail.store(tail + 1, std::memory_order_release);
+            ch->signal.notify();
+            served++;
+        }
+    }
+    numFrames += served;
+    return served;
+}
+
+
+ShmClient::ShmClient(const std::string& name, int channel)
+    : segment(name, 0, 0, 0), channel(channel)
+{
+    if (channel < 0 || channel >= (int)segment.header()->numChannels)
+        throw std::runtime_error("no channel " + std::to_string(channel) + " in " + name);
+    state = segment.channel(channel);
+
+    // take a free channel, or the channel of a worker that died without detaching
+    int32_t pid = getpid();
+    int32_t expected = 0;
+    while (!state->owner.compare_exchange_strong(expected, pid))
+        if (expected == pid || kill(expected, 0) == 0 || errno != ESRCH)
+            throw std::runtime_error("channel " + std::to_string(channel) + " of " + name + " is taken");
+    session = state->numSessions.fetch_add(1) + 1;
+}
+
+
+ShmClient::~ShmClient()
+{
+    state->owner.store(0);
+}
+
+
+ShmDetection* ShmClient::acquire(std::chrono::microseconds timeout)
+{
+    uint32_t numSlots = segment.header()->numSlots;
+    uint32_t tail = state->requests.tail.load(std::memory_order_relaxed);
+    auto hasRoom = [&]() { return tail - state->requests.head.load(std::memory_order_acquire) < numSlots; };
+    if (!state->signal.wait(hasRoom, timeout))
+        return nullptr;
+    return records<ShmDetection>(segment.slot(channel, false, tail));
+}
+
+
+void ShmClient::submit(int64_t frameIndex, int count)
+{
+    assert(count >= 0 && count <= getMaxDets());
+    uint32_t tail = state->requests.tail.load(std::memory_order_relaxed);
+    ShmSlotHeader* request = segment.slot(channel, false, tail);
+    request->frameIndex = frameIndex;
+    request->count = count;
+    request->session = session;
+    state->requests.tail.store(tail + 1, std::memory_order_release);
+    segment.header()->doorbell.notify();
+}
+
+
+bool ShmClient::receive(int64_t& frameIndex, cv::Mat& tracks, std::chrono::microseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true)
+    {
+        uint32_t head = state->responses.head.load(std::memory_order_relaxed);
+        auto hasTracks = [&]() { return head != state->responses.tail.load(std::memory_order_acquire); };
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+        if (!state->signal.wait(hasTracks, left))
+            return false;
+
+        // frames left in flight by a previous worker are dropped
+        isHolding = true;
+        ShmSlotHeader* response = segment.slot(channel, true, head);
+        if (response->session != session)
+        {
+            release();
+            continue;
+        }
+        frameIndex = response->frameIndex;
+        tracks = cv::Mat(response->count, TRACK_COLS, CV_32F, records<ShmTrack>(response));
+        return true;
+    }
+}
+
+
+void ShmClient::release()
+{
+    if (!isHolding) return;
+    isHolding = false;
+    state->responses.head.fetch_add(1, std::memory_order_release);
+    segment.header()->doorbell.notify();
+}
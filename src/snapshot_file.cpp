@@ -0,0 +1,213 @@
+#include "snapshot_file.h"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace sort;
+
+namespace
+{
+    constexpr char FILE_MAGIC[8] = {'S', 'O', 'R', 'T', 'S', 'N', 'F', '\0'};
+    constexpr size_t MIN_CAPACITY = 64 * 1024;
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint64_t capacity;      // payload bytes of each slot
+    };
+
+    struct SlotHeader
+    {
+        uint64_t sequence;      // 0: empty, the newest slot has the largest sequence
+        uint64_t size;          // payload bytes
+    };
+
+    inline size_t slotOffset(size_t capacity, int slot)
+    {
+        return sizeof(FileHeader) + slot * (sizeof(SlotHeader) + capacity);
+    }
+
+    inline SlotHeader* slotHeader(uint8_t* base, size_t capacity, int slot)
+    {
+        return reinterpret_cast<SlotHeader*>(base + slotOffset(capacity, slot));
+    }
+}
+
+
+SnapshotFile::SnapshotFile(const std::string& path)
+    : path(path)
+{
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + path);
+    remap();
+    if (length == 0)
+        reserve(MIN_CAPACITY);
+}
+
+
+SnapshotFile::~SnapshotFile()
+{
+    if (ptr != nullptr)
+        munmap(ptr, length);
+    if (fd >= 0)
+        close(fd);
+}
+
+
+void SnapshotFile::remap()
+{
+    struct stat st, current;
+    if (fstat(fd, &st) != 0)
+        throw std::runtime_error("cannot stat " + path);
+
+    // the writer renamed a grown file over the path
+    if (stat(path.c_str(), &current) == 0 && (current.st_ino != st.st_ino || current.st_dev != st.st_dev))
+    {
+        int newFd = open(path.c_str(), O_RDWR);
+        if (newFd >= 0 && fstat(newFd, &st) == 0)
+        {
+            if (ptr != nullptr)
+                munmap(ptr, length);
+            ptr = nullptr;
+            length = 0;
+            close(fd);
+            fd = newFd;
+        }
+        else if (newFd >= 0)
+            close(newFd);
+    }
+    if ((size_t)st.st_size == length) return;
+
+    if (ptr != nullptr)
+        munmap(ptr, length);
+    ptr = nullptr;
+    length = st.st_size;
+    if (length == 0) return;
+
+    void* addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+        throw std::runtime_error("cannot mmap " + path);
+    ptr = static_cast<uint8_t*>(addr);
+}
+
+
+void SnapshotFile::reserve(size_t capacity)
+{
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(ptr);
+    bool isValid = ptr != nullptr && length >= slotOffset(0, 0) &&
+                   memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+                   length >= slotOffset(header->capacity, 2);
+    if (isValid && header->capacity >= capacity) return;
+
+    // slots move when the capacity changes: the grown file is prepared aside, holding the newest
+    // snapshot, then renamed over the path. the current file stays valid until the rename
+    size_t newCapacity = MIN_CAPACITY;
+    while (newCapacity < capacity) newCapacity *= 2;
+    size_t newLength = slotOffset(newCapacity, 2);
+
+    std::string tmpPath = path + ".tmp";
+    int newFd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (newFd < 0)
+        throw std::runtime_error("cannot open " + tmpPath);
+    void* addr = ftruncate(newFd, newLength) == 0 ?
+                 mmap(nullptr, newLength, PROT_READ | PROT_WRITE, MAP_SHARED, newFd, 0) : MAP_FAILED;
+    if (addr == MAP_FAILED)
+    {
+        close(newFd);
+        unlink(tmpPath.c_str());
+        throw std::runtime_error("cannot resize " + tmpPath);
+    }
+    uint8_t* newPtr = static_cast<uint8_t*>(addr);
+
+    FileHeader* newHeader = reinterpret_cast<FileHeader*>(newPtr);
+    memcpy(newHeader->magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    newHeader->capacity = newCapacity;
+    for (int slot = 0; slot < 2; ++slot)
+        memset(slotHeader(newPtr, newCapacity, slot), 0, sizeof(SlotHeader));
+
+    // this process is the only writer, the newest slot does not change while it is copied
+    if (isValid)
+    {
+        const SlotHeader* slots[2] = {slotHeader(ptr, header->capacity, 0), slotHeader(ptr, header->capacity, 1)};
+        int newest = slots[0]->sequence >= slots[1]->sequence ? 0 : 1;
+        if (slots[newest]->sequence > 0)
+        {
+            SlotHeader* target = slotHeader(newPtr, newCapacity, 0);
+            target->size = std::min<uint64_t>(slots[newest]->size, header->capacity);
+            memcpy(target + 1, slots[newest] + 1, target->size);
+            target->sequence = slots[newest]->sequence;
+        }
+    }
+
+    bool isSynced = msync(newPtr, newLength, MS_SYNC) == 0 && fsync(newFd) == 0;
+    munmap(newPtr, newLength);
+    if (!isSynced || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        close(newFd);
+        unlink(tmpPath.c_str());
+        throw std::runtime_error("cannot replace " + path);
+    }
+
+    if (ptr != nullptr)
+        munmap(ptr, length);
+    ptr = nullptr;
+    length = 0;
+    close(fd);
+    fd = newFd;
+    remap();
+}
+
+
+void SnapshotFile::save(const Sort& mot)
+{
+    remap();
+    reserve(mot.snapshotSize());
+    size_t capacity = reinterpret_cast<FileHeader*>(ptr)->capacity;
+
+    // overwrite the older slot, then publish it with a newer sequence
+    SlotHeader* slots[2] = {slotHeader(ptr, capacity, 0), slotHeader(ptr, capacity, 1)};
+    uint64_t seq0 = __atomic_load_n(&slots[0]->sequence, __ATOMIC_ACQUIRE);
+    uint64_t seq1 = __atomic_load_n(&slots[1]->sequence, __ATOMIC_ACQUIRE);
+    int target = seq0 <= seq1 ? 0 : 1;
+
+    __atomic_store_n(&slots[target]->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slots[target]->size = mot.snapshot(reinterpret_cast<uint8_t*>(slots[target] + 1), capacity);
+    __atomic_store_n(&slots[target]->sequence, std::max(seq0, seq1) + 1, __ATOMIC_RELEASE);
+}
+
+
+bool SnapshotFile::load(Sort& mot)
+{
+    remap();
+    if (length < slotOffset(0, 0)) return false;
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(ptr);
+    if (memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) return false;
+    size_t capacity = header->capacity;
+    if (length < slotOffset(capacity, 2)) return false;
+
+    SlotHeader* slots[2] = {slotHeader(ptr, capacity, 0), slotHeader(ptr, capacity, 1)};
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        uint64_t seq0 = __atomic_load_n(&slots[0]->sequence, __ATOMIC_ACQUIRE);
+        uint64_t seq1 = __atomic_load_n(&slots[1]->sequence, __ATOMIC_ACQUIRE);
+        if (seq0 == 0 && seq1 == 0) return false;
+        int newest = seq0 >= seq1 ? 0 : 1;
+        uint64_t seq = newest == 0 ? seq0 : seq1;
+
+        // copy out, then check the writer did not start overwriting the slot meanwhile
+        size_t size = std::min<uint64_t>(slots[newest]->size, capacity);
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(slots[newest] + 1);
+        vector<uint8_t> data(payload, payload + size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slots[newest]->sequence, __ATOMIC_ACQUIRE) != seq) continue;
+
+        mot.restore(data);
+        return true;
+    }
+    return false;
+}
@@ -1,130 +1,494 @@
 #include "sort.h"
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
 
 using namespace sort;
 
-Sort::Sort(int maxAge, int minHits, float iouThresh)
+namespace
+{
+    constexpr int MIN_BLOCK_SIZE = 16;  // items per block below which the parallel mode runs serially
+
+    /**
+     * @brief the count highest scoring detections of indices, ties to the lower index
+     * @param bboxesDet detections, Mat(M, 6), the score in column 4
+     * @param indices ascending rows of bboxesDet
+     * @param count detections to keep
+     * @return kept rows, ascending
+     */
+    std::vector<int> keepBestScores(const cv::Mat &bboxesDet, const std::vector<int> &indices, size_t count)
+    {
+        std::vector<int> kept = indices;
+        std::stable_sort(kept.begin(), kept.end(), [&](int a, int b) {
+            return bboxesDet.at<float>(a, 4) > bboxesDet.at<float>(b, 4);
+        });
+        kept.resize(std::min(count, kept.size()));
+        std::sort(kept.begin(), kept.end());
+        return kept;
+    }
+}
+
+
+template<class Model>
+SortT<Model>::SortT(int maxAge, int minHits, float iouThresh)
     : maxAge(maxAge), minHits(minHits), iouThresh(iouThresh)
 {
-    km = std::make_shared<KuhnMunkres>();
+    solver = std::make_shared<AssociationSolver>();
+}
+
+
+template<class Model>
+SortT<Model>::~SortT()
+{
+}
+
+
+template<class Model>
+void SortT<Model>::setNumThreads(int numThreads)
+{
+    assert(numThreads != 0);
+    threadPool = numThreads > 1 ? std::make_shared<ThreadPool>(numThreads) : nullptr;
+}
+
+
+template<class Model>
+void SortT<Model>::setPrivateIds(bool enable)
+{
+    if (enable && nextId < 0)
+        nextId = TrackerIds::getFilterCount();
+    else if (!enable && nextId >= 0)
+    {
+        TrackerIds::reserveFilterIds(nextId);
+        nextId = -1;
+    }
 }
 
 
-Sort::~Sort()
+template<class Model>
+TrackEventRing::Ptr SortT<Model>::enableEvents(size_t capacity)
 {
+    events = capacity > 0 ? std::make_shared<TrackEventRing>(capacity) : nullptr;
+    return events;
 }
 
 
-cv::Mat Sort::update(const cv::Mat &bboxesDet)
+template<class Model>
+cv::Mat SortT<Model>::update(const cv::Mat &bboxesDet)
 {
     assert(bboxesDet.rows >= 0 && bboxesDet.cols == 6); // detections, [xc, yc, w, h, score, class_id]
+    recordInput(bboxesDet);
+    frameCount++;
+
+    // kalman bbox tracker predict, every tracker writes its own row
+    int numTrackers = trackers.size();
+    cv::Mat bboxesPred(numTrackers, 6, CV_32F, cv::Scalar(0));  // predictions used in data association, [xc, yc, w, h, ...]
+    parallelFor(numTrackers, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+        {
+            cv::Mat bboxPred = trackers[i]->predict();   // Mat(1, 4)
+            for (int c = 0; c < 4; ++c)
+                bboxesPred.at<float>(i, c) = bboxPred.at<float>(0, c);
+        }
+    });
+
+    return associate(bboxesDet, bboxesPred);
+}
 
-    cv::Mat bboxesPred(0, 6, CV_32F, cv::Scalar(0));  // predictions used in data association, [xc, yc, w, h, ...]
-    cv::Mat bboxesPost(0, 9, CV_32F, cv::Scalar(0));  // bounding boxes estimate, [xc, yc, w, h, score, class_id, vx, vy, tracker_id]
 
-    // kalman bbox tracker predict
-    for (auto it = trackers.begin(); it != trackers.end();)
+template<class Model>
+cv::Mat SortT<Model>::associate(const cv::Mat &bboxesDet, cv::Mat &bboxesPred, bool deferBirths)
+{
+    if (maxDetections > 0 && bboxesDet.rows > maxDetections)
+        return associate(shedDetections(bboxesDet), bboxesPred, deferBirths);
+
+    // remove the NAN value and corresponding tracker
+    int numTrackers = trackers.size();
+    int numValid = 0;
+    for (int i = 0; i < numTrackers; ++i)
     {
-        cv::Mat bboxPred = (*it)->predict();   // Mat(1, 4)
-        if (isAnyNan<float>(bboxPred))
-            trackers.erase(it);     // remove the NAN value and corresponding tracker
-        else{
-            cv::hconcat(bboxPred, cv::Mat(1, 2, CV_32F,cv::Scalar(0)), bboxPred);   // Mat(1, 6)
-            cv::vconcat(bboxesPred, bboxPred, bboxesPred);  // Mat(N, 6)
-            ++it;
+        if (isAnyNan<float>(bboxesPred.rowRange(i, i + 1)))
+        {
+            emitEvent(TrackEventType::DELETED, trackers[i]->getFilterId(), bboxesPred.ptr<float>(i));
+            dropTrajectory(trackers[i]->getFilterId());
+            pool.release(std::move(trackers[i]));
+            continue;
+        }
+        if (numValid != i)
+        {
+            trackers[numValid] = std::move(trackers[i]);
+            for (int c = 0; c < 4; ++c)
+                bboxesPred.at<float>(numValid, c) = bboxesPred.at<float>(i, c);
         }
+        numValid++;
     }
+    trackers.resize(numValid);
+    bboxesPred = bboxesPred.rowRange(0, numValid);  // Mat(N, 6)
 
     TypeAssociate asTuple = dataAssociate(bboxesDet, bboxesPred);
     TypeMatchedPairs matchedDetPred = std::get<0>(asTuple);
     TypeLostDets lostDets = std::get<1>(asTuple);
     TypeLostPreds lostPreds = std::get<2>(asTuple);
 
-    // update matched trackers with assigned detections
-    for (auto pair : matchedDetPred)
+    // update matched trackers with assigned detections, row k belongs to matched pair k
+    int numMatched = matchedDetPred.size();
+    cv::Mat bboxesMatched(numMatched, 9, CV_32F, cv::Scalar(0));
+    vector<char> isConfirmed(numMatched, 0);
+    parallelFor(numMatched, [&](int begin, int end) {
+        for (int k = begin; k < end; ++k)
+        {
+            int detInd = matchedDetPred[k].first;
+            int predInd = matchedDetPred[k].second;
+            cv::Mat bboxPost = trackers[predInd]->update(bboxesDet.rowRange(detInd, detInd + 1));
+            float* row = bboxesMatched.ptr<float>(k);
+            for (int c = 0; c < 4; ++c)
+                row[c] = bboxPost.at<float>(0, c);
+
+            if (trackers[predInd]->getHitStreak() >= minHits)
+            {
+                cv::Mat state = trackers[predInd]->getState();
+                row[4] = bboxesDet.at<float>(detInd, 4);            // score
+                row[5] = int(bboxesDet.at<float>(detInd, 5));       // class_id
+                row[6] = state.at<float>(Model::VX, 0);             // dx
+                row[7] = state.at<float>(Model::VY, 0);             // dy
+                row[8] = trackers[predInd]->getFilterId();          // tracker_id
+                isConfirmed[k] = 1;
+            }
+        }
+    });
+
+    // bounding boxes estimate in matched order, [xc, yc, w, h, score, class_id, vx, vy, tracker_id]
+    cv::Mat bboxesPost(std::count(isConfirmed.begin(), isConfirmed.end(), 1), 9, CV_32F, cv::Scalar(0));
+    for (int k = 0, n = 0; k < numMatched; ++k)
+        if (isConfirmed[k])
+        {
+            // once per tracker, a track rebuilding its hit streak after a miss is not confirmed again
+            auto& tracker = trackers[matchedDetPred[k].second];
+            if (!tracker->isConfirmed())
+            {
+                tracker->setConfirmed();
+                emitEvent(TrackEventType::CONFIRMED, bboxesMatched.at<float>(k, 8), bboxesMatched.ptr<float>(k));
+            }
+            for (int c = 0; c < 9; ++c)
+                bboxesPost.at<float>(n, c) = bboxesMatched.at<float>(k, c);
+            n++;
+        }
+
+    // trackers unmatched for the first time
+    for (int predInd : lostPreds)
+        if (trackers[predInd]->getTimeSinceUpdate() == 1)
+            emitEvent(TrackEventType::LOST, trackers[predInd]->getFilterId(), bboxesPred.ptr<float>(predInd));
+
+    // trajectories, corrected states of the matched trackers and predictions of the others
+    if (trajectories != nullptr)
     {
-        int detInd = pair.first;
-        int predInd = pair.second;
-        cv::Mat bboxPost = trackers[predInd]->update(bboxesDet.rowRange(detInd, detInd + 1));
+        for (int k = 0; k < numMatched; ++k)
+            recordState(trackers[matchedDetPred[k].second]->getFilterId(), bboxesMatched.ptr<float>(k));
+        for (int predInd : lostPreds)
+            recordState(trackers[predInd]->getFilterId(), bboxesPred.ptr<float>(predInd));
+    }
 
-        if (trackers[predInd]->getHitStreak() >= minHits)
+    // remove dead trackers, keeping the order of the others
+    size_t numAlive = 0;
+    for (size_t i = 0; i < trackers.size(); ++i)
+    {
+        if (trackers[i]->getTimeSinceUpdate() > maxAge)
         {
-            float score = bboxesDet.at<float>(detInd, 4);
-            int classId = bboxesDet.at<float>(detInd, 5);
-            float dx = trackers[predInd]->getState().at<float>(4, 0);
-            float dy = trackers[predInd]->getState().at<float>(5, 0);
-            int trackerId = trackers[predInd]->getFilterId();
-            cv::Mat tailData = (cv::Mat_<float>(1, 5) << score, classId, dx, dy, trackerId);
-            cv::hconcat(bboxPost, tailData, bboxPost);
-            cv::vconcat(bboxesPost, bboxPost, bboxesPost);  // Mat(N, 9)
+            emitEvent(TrackEventType::DELETED, trackers[i]->getFilterId(), bboxesPred.ptr<float>(i));
+            dropTrajectory(trackers[i]->getFilterId());
+            pool.release(std::move(trackers[i]));
         }
+        else
+            trackers[numAlive++] = std::move(trackers[i]);
     }
+    trackers.resize(numAlive);
 
-    // remove dead trackers
-    trackers.erase(
-        std::remove_if(trackers.begin(), trackers.end(),
-            [&](const KalmanBoxTracker::Ptr& kbt)->bool {
-                return kbt->getTimeSinceUpdate() > maxAge;
-            }),
-        trackers.end()
-    );
-
-    // create and initialize new trackers for unmatched detections
-    for (int lostInd : lostDets)
+    // create and initialize new trackers for unmatched detections, the highest scoring ones within maxTracks
+    if (maxTracks > 0 && trackers.size() + lostDets.size() > size_t(maxTracks))
     {
-        cv::Mat lostBbox = bboxesDet.rowRange(lostInd, lostInd + 1);
-        trackers.push_back(make_shared<KalmanBoxTracker>(lostBbox));
+        size_t room = trackers.size() < size_t(maxTracks) ? maxTracks - trackers.size() : 0;
+        numShedBirths += lostDets.size() - room;
+        lostDets = keepBestScores(bboxesDet, lostDets, room);
     }
+    birthDets = bboxesDet;
+    births.swap(lostDets);
+    if (!deferBirths)
+        createTrackers();
 
     return bboxesPost;
 }
 
 
-TypeAssociate Sort::dataAssociate(const cv::Mat& bboxesDet, const cv::Mat& bboxesPred)
+template<class Model>
+void SortT<Model>::createTrackers()
+{
+    for (int lostInd : births)
+    {
+        cv::Mat lostBbox = birthDets.rowRange(lostInd, lostInd + 1);
+        trackers.push_back(pool.acquire(lostBbox, nextId < 0 ? -1 : nextId++));
+        emitEvent(TrackEventType::BORN, trackers.back()->getFilterId(), lostBbox.ptr<float>(0));
+        recordState(trackers.back()->getFilterId(), lostBbox.ptr<float>(0));
+    }
+    births.clear();
+    birthDets = cv::Mat();
+}
+
+
+template<class Model>
+cv::Mat SortT<Model>::shedDetections(const cv::Mat &bboxesDet)
+{
+    std::vector<int> rows(bboxesDet.rows);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::vector<int> kept = keepBestScores(bboxesDet, rows, maxDetections);
+    numShedDetections += bboxesDet.rows - kept.size();
+
+    cv::Mat bboxesKept(kept.size(), bboxesDet.cols, bboxesDet.type());
+    for (size_t k = 0; k < kept.size(); ++k)
+        for (int c = 0; c < bboxesDet.cols; ++c)
+            bboxesKept.at<float>(k, c) = bboxesDet.at<float>(kept[k], c);
+    return bboxesKept;
+}
+
+
+template<class Model>
+SortMemoryUsage SortT<Model>::memoryUsage() const
+{
+    SortMemoryUsage usage;
+    for (const auto& tracker : trackers)
+        usage.trackers += tracker->memoryUsage();
+    usage.pool = pool.memoryUsage();
+    usage.solver = solver->memoryUsage();
+    usage.events = events != nullptr ? sizeof(TrackEventRing) + events->capacity() * sizeof(TrackEvent) : 0;
+    usage.trajectories = trajectories != nullptr ? trajectories->memoryUsage() : 0;
+    usage.deltas = deltaEncoder != nullptr ? deltaEncoder->memoryUsage() : 0;
+    usage.recorder = recorder != nullptr ? recorder->memoryUsage() : 0;
+    usage.self = sizeof(*this) + trackers.capacity() * sizeof(typename Tracker::Ptr);
+    return usage;
+}
+
+
+template<class Model>
+size_t SortT<Model>::snapshotSize() const
+{
+    return sizeof(SortSnapshotHeader) + trackers.size() * sizeof(typename Tracker::State);
+}
+
+
+template<class Model>
+size_t SortT<Model>::snapshot(uint8_t* buffer, size_t capacity) const
+{
+    size_t size = snapshotSize();
+    if (capacity < size) return 0;
+
+    SortSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SORT_SNAPSHOT_MAGIC, sizeof(SORT_SNAPSHOT_MAGIC));
+    header.version = SORT_SNAPSHOT_VERSION;
+    header.recordSize = sizeof(typename Tracker::State);
+    header.maxAge = maxAge;
+    header.minHits = minHits;
+    header.iouThresh = iouThresh;
+    header.filterCount = nextId < 0 ? TrackerIds::getFilterCount() : nextId;
+    header.numTrackers = trackers.size();
+    header.frameCount = frameCount;
+    header.maxTracks = maxTracks;
+    header.maxDetections = maxDetections;
+    header.maxSolverDimension = solver->getMaxDimension();
+    header.adaptiveSolver = solver->isAdaptive();
+    memcpy(buffer, &header, sizeof(header));
+
+    typename Tracker::State state;
+    uint8_t* record = buffer + sizeof(header);
+    for (const auto& kbt : trackers)
+    {
+        kbt->exportState(state);
+        memcpy(record, &state, sizeof(state));
+        record += sizeof(state);
+    }
+
+    return size;
+}
+
+
+template<class Model>
+vector<uint8_t> SortT<Model>::snapshot() const
+{
+    vector<uint8_t> buffer(snapshotSize());
+    snapshot(buffer.data(), buffer.size());
+    return buffer;
+}
+
+
+template<class Model>
+void SortT<Model>::restore(const uint8_t* data, size_t size)
+{
+    SortSnapshotHeader header;
+    if (data == nullptr || size < sizeof(header))
+        throw std::runtime_error("truncated snapshot");
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SORT_SNAPSHOT_MAGIC, sizeof(SORT_SNAPSHOT_MAGIC)) != 0)
+        throw std::runtime_error("not a snapshot");
+    if (header.version != SORT_SNAPSHOT_VERSION || header.recordSize != sizeof(typename Tracker::State))
+        throw std::runtime_error("unsupported snapshot version");
+    if (size < sizeof(header) + size_t(header.numTrackers) * sizeof(typename Tracker::State))
+        throw std::runtime_error("truncated snapshot");
+
+    maxAge = header.maxAge;
+    minHits = header.minHits;
+    iouThresh = header.iouThresh;
+    frameCount = header.frameCount;
+    maxTracks = header.maxTracks;
+    maxDetections = header.maxDetections;
+    solver->setMaxDimension(header.maxSolverDimension);
+    solver->setAdaptive(header.adaptiveSolver != 0);
+    if (nextId < 0)
+        TrackerIds::reserveFilterIds(header.filterCount);
+    else
+        nextId = header.filterCount;
+
+    for (auto& kbt : trackers)
+        pool.release(std::move(kbt));
+    trackers.clear();
+
+    // trajectories are not part of the snapshot, they restart from the restored states
+    if (trajectories != nullptr)
+        trajectories = std::make_shared<TrajectoryBank>(trajectories->getCapacity());
+
+    // a standby instance has an empty pool, the trackers are built in one block and overwritten in place
+    pool.reserve(header.numTrackers);
+    trackers.reserve(header.numTrackers);
+    typename Tracker::State state;
+    const uint8_t* record = data + sizeof(header);
+    for (uint32_t i = 0; i < header.numTrackers; ++i)
+    {
+        memcpy(&state, record, sizeof(state));
+        trackers.push_back(pool.acquire(state));
+        record += sizeof(state);
+    }
+}
+
+
+template<class Model>
+TraceRecorder::Ptr SortT<Model>::enableRecording(const std::string& path, size_t bufferSize)
+{
+    recorder = nullptr;     // closes the previous trace first
+    if (!path.empty())
+        recorder = std::make_shared<TraceRecorder>(path, snapshot(), bufferSize);
+    return recorder;
+}
+
+
+template<class Model>
+void SortT<Model>::enableTrajectories(size_t capacity)
+{
+    trajectories = capacity > 0 ? std::make_shared<TrajectoryBank>(capacity) : nullptr;
+}
+
+
+template<class Model>
+TrajectoryView SortT<Model>::getTrajectory(int trackerId) const
+{
+    return trajectories != nullptr ? trajectories->get(trackerId) : TrajectoryView();
+}
+
+
+template<class Model>
+vector<TrajectoryView> SortT<Model>::getTrajectories() const
+{
+    return trajectories != nullptr ? trajectories->getAll() : vector<TrajectoryView>();
+}
+
+
+template<class Model>
+vector<int> SortT<Model>::getTrackerIds() const
+{
+    vector<int> ids;
+    ids.reserve(trackers.size());
+    for (const auto& tracker : trackers)
+        ids.push_back(tracker->getFilterId());
+    return ids;
+}
+
+
+template<class Model>
+TrackDelta SortT<Model>::updateDelta(const cv::Mat &bboxesDet)
+{
+    if (deltaEncoder == nullptr)
+        deltaEncoder = std::make_shared<DeltaEncoder>();
+    return deltaEncoder->encode(update(bboxesDet));
+}
+
+
+template<class Model>
+void SortT<Model>::setDeltaTolerances(float posTol, float sizeTol)
+{
+    deltaEncoder = std::make_shared<DeltaEncoder>(posTol, sizeTol);
+}
+
+
+template<class Model>
+TypeAssociate SortT<Model>::dataAssociate(const cv::Mat& bboxesDet, const cv::Mat& bboxesPred)
 {
     TypeMatchedPairs matchedDetPred;
     TypeLostDets lostDets;
     TypeLostPreds lostPreds;
 
-    // initialize
-    for (int i = 0; i < bboxesDet.rows; ++i)
-        lostDets.push_back(i);  // size M
-    for (int j = 0; j < bboxesPred.rows; ++j)
-        lostPreds.push_back(j); // size N
-
     // nothing detected or predicted
     if (bboxesDet.rows == 0 || bboxesPred.rows == 0)
+    {
+        for (int i = 0; i < bboxesDet.rows; ++i)
+            lostDets.push_back(i);  // size M
+        for (int j = 0; j < bboxesPred.rows; ++j)
+            lostPreds.push_back(j); // size N
         return make_tuple(matchedDetPred, lostDets, lostPreds);
+    }
 
-    // compute IoU matrix
-    cv::Mat iouMat = getIouMatrix(bboxesDet, bboxesPred);   // Mat(M, N)
+    // compute IoU matrix, row blocks are independent
+    cv::Mat iouMat(bboxesDet.rows, bboxesPred.rows, CV_32F, cv::Scalar(0.0));   // Mat(M, N)
+    parallelFor(bboxesDet.rows, [&](int begin, int end) {
+        getIouRows(bboxesDet, bboxesPred, begin, end, iouMat);
+    });
 
-    // Kuhn Munkres assignment algorithm
-    Vec2f costMatrix(iouMat.rows, Vec1f(iouMat.cols, 0.0f));
-    for (int i = 0; i < iouMat.rows; ++i)
-        for (int j = 0; j < iouMat.cols; ++j)
-            costMatrix[i][j] = 1.0f - iouMat.at<float>(i, j);
-    auto indices = km->compute(costMatrix);
+    // assignment maximizing the total IoU, pairs without overlap are only needed when iouThresh accepts them
+    auto indices = solver->solve(iouMat, iouThresh > 0);
 
-    // find matched pairs and lost detect and predict
+    // find matched pairs and lost detect and predict, pairs overlapping less than iouThresh stay unmatched
+    vector<char> isDetMatched(bboxesDet.rows, 0), isPredMatched(bboxesPred.rows, 0);
     for (auto [detInd, predInd] : indices) {
+        if (iouMat.at<float>(detInd, predInd) < iouThresh)
+            continue;
         matchedDetPred.push_back({detInd, predInd});
-        lostDets.erase(remove(lostDets.begin(), lostDets.end(), detInd), lostDets.end());
-        lostPreds.erase(remove(lostPreds.begin(), lostPreds.end(), predInd), lostPreds.end());
+        isDetMatched[detInd] = 1;
+        isPredMatched[predInd] = 1;
     }
+    for (int i = 0; i < bboxesDet.rows; ++i)
+        if (!isDetMatched[i]) lostDets.push_back(i);
+    for (int j = 0; j < bboxesPred.rows; ++j)
+        if (!isPredMatched[j]) lostPreds.push_back(j);
 
     return make_tuple(matchedDetPred, lostDets, lostPreds);
 }
 
 
-cv::Mat Sort::getIouMatrix(const cv::Mat& bboxesA, const cv::Mat& bboxesB)
+template<class Model>
+cv::Mat SortT<Model>::getIouMatrix(const cv::Mat& bboxesA, const cv::Mat& bboxesB)
 {
     assert(bboxesA.cols >= 4 && bboxesB.cols >= 4);
-    int numA = bboxesA.rows;
+    cv::Mat iouMat(bboxesA.rows, bboxesB.rows, CV_32F, cv::Scalar(0.0));
+    getIouRows(bboxesA, bboxesB, 0, bboxesA.rows, iouMat);
+
+    return iouMat;
+}
+
+
+template<class Model>
+void SortT<Model>::getIouRows(const cv::Mat& bboxesA, const cv::Mat& bboxesB, int rowBegin, int rowEnd, cv::Mat& iouMat)
+{
+    assert(bboxesA.cols >= 4 && bboxesB.cols >= 4);
+    assert(iouMat.rows == bboxesA.rows && iouMat.cols == bboxesB.rows);
     int numB = bboxesB.rows;
-    cv::Mat iouMat(numA, numB, CV_32F, cv::Scalar(0.0));
 
     cv::Rect re1, re2;
-    for (int i = 0; i < numA; ++i)
+    for (int i = rowBegin; i < rowEnd; ++i)
     {
         for (int j = 0; j < numB; ++j)
         {
@@ -140,6 +504,26 @@ cv::Mat Sort::getIouMatrix(const cv::Mat& bboxesA, const cv::Mat& bboxesB)
             iouMat.at<float>(i, j) = (re1 & re2).area() / ((re1 | re2).area() + FLT_EPSILON);
         }
     }
+}
 
-    return iouMat;
-}
\ No newline at end of file
+
+template<class Model>
+void SortT<Model>::parallelFor(int n, const std::function<void(int, int)>& body)
+{
+    int numBlocks = threadPool == nullptr ? 1 :
+                    std::min(threadPool->getNumThreads() * 4, (n + MIN_BLOCK_SIZE - 1) / MIN_BLOCK_SIZE);
+    if (numBlocks <= 1)
+    {
+        body(0, n);
+        return;
+    }
+
+    threadPool->run(numBlocks, [&](int b) {
+        body(int((long long)n * b / numBlocks), int((long long)n * (b + 1) / numBlocks));
+    });
+}
+
+
+template class sort::SortT<ConstantVelocityModel>;
+template class sort::SortT<ReducedVelocityModel>;
+template class sort::SortT<ConstantAccelerationModel>;
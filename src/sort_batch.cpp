@@ -0,0 +1,75 @@
+#include "sort_batch.h"
+#include <algorithm>
+
+using namespace sort;
+
+template<class Model>
+SortBatchT<Model>::SortBatchT(int numThreads)
+{
+    if (numThreads != 1)
+        threadPool = make_shared<ThreadPool>(numThreads);
+}
+
+
+template<class Model>
+SortBatchT<Model>::~SortBatchT()
+{
+}
+
+
+template<class Model>
+vector<cv::Mat> SortBatchT<Model>::update(const vector<Stream>& streams, const vector<cv::Mat>& bboxesDets)
+{
+    assert(streams.size() == bboxesDets.size());
+    int numStreams = streams.size();
+
+    // gather the corrected states of every stream
+    offsets.resize(numStreams + 1);
+    offsets[0] = 0;
+    for (int s = 0; s < numStreams; ++s)
+        offsets[s + 1] = offsets[s] + streams[s]->trackers.size();
+    size_t numTrackers = offsets[numStreams];
+    if (numTrackers > capacity)
+    {
+        capacity = std::max(numTrackers, 2 * capacity);
+        x.resize(Tracker::DIM_X * capacity);
+        errorCov.resize(Tracker::DIM_X * Tracker::DIM_X * capacity);
+    }
+    for (int s = 0; s < numStreams; ++s)
+        for (int i = 0, t = offsets[s]; t < offsets[s + 1]; ++i, ++t)
+            streams[s]->trackers[i]->gatherPost(x.data() + t, errorCov.data() + t, capacity);
+
+    Tracker::predictBatch(x.data(), errorCov.data(), numTrackers, capacity);
+
+    // scatter the predictions back and associate every stream independently
+    vector<cv::Mat> outputs(numStreams);
+    auto track = [&](int s) {
+        assert(bboxesDets[s].rows >= 0 && bboxesDets[s].cols == 6);
+        SortT<Model>& mot = *streams[s];
+        mot.recordInput(bboxesDets[s]);
+        mot.frameCount++;
+        cv::Mat bboxesPred(offsets[s + 1] - offsets[s], 6, CV_32F, cv::Scalar(0));
+        for (int i = 0, t = offsets[s]; t < offsets[s + 1]; ++i, ++t)
+        {
+            cv::Mat bboxPred = mot.trackers[i]->scatterPrior(x.data() + t, errorCov.data() + t, capacity);
+            for (int c = 0; c < 4; ++c)
+                bboxesPred.at<float>(i, c) = bboxPred.at<float>(0, c);
+        }
+        outputs[s] = mot.associate(bboxesDets[s], bboxesPred, true);
+    };
+    if (threadPool != nullptr)
+        threadPool->run(numStreams, track);
+    else
+        for (int s = 0; s < numStreams; ++s) track(s);
+
+    // new trackers take their ids in stream order, whatever the scheduling of the associations
+    for (int s = 0; s < numStreams; ++s)
+        streams[s]->createTrackers();
+
+    return outputs;
+}
+
+
+template class sort::SortBatchT<ConstantVelocityModel>;
+template class sort::SortBatchT<ReducedVelocityModel>;
+template class sort::SortBatchT<ConstantAccelerationModel>;
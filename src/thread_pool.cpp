@@ -0,0 +1,83 @@
+#include "thread_pool.h"
+
+using namespace sort;
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    if (numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < numThreads; ++i)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+
+void ThreadPool::run(int count, const Task& job)
+{
+    if (count <= 0) return;
+    if (workers.empty() || count == 1)
+    {
+        for (int i = 0; i < count; ++i) job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        task = &job;
+        numTasks = count;
+        nextTask = 0;
+        busyWorkers = workers.size();
+        generation++;
+    }
+    wakeUp.notify_all();
+
+    drain(job, count);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    finished.wait(lock, [this] { return busyWorkers == 0; });
+    task = nullptr;
+}
+
+
+void ThreadPool::workerLoop()
+{
+    size_t seen = 0;
+    while (true)
+    {
+        const Task* job;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            job = task;
+            count = numTasks;
+        }
+
+        drain(*job, count);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (--busyWorkers == 0)
+            finished.notify_one();
+    }
+}
+
+
+void ThreadPool::drain(const Task& job, int count)
+{
+    for (int i = nextTask++; i < count; i = nextTask++)
+        job(i);
+}
@@ -0,0 +1,187 @@
+#include "trace_recorder.h"
+#include <assert.h>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace sort;
+
+namespace
+{
+    constexpr int TRACE_NUM_COLS = 6;  // xc, yc, w, h, score, class_id
+
+    template<typename _Tp>
+    inline void append(std::vector<uint8_t>& buffer, const _Tp* src, size_t count)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+        buffer.insert(buffer.end(), bytes, bytes + count * sizeof(_Tp));
+    }
+}
+
+
+TraceRecorder::TraceRecorder(const std::string& path, const std::vector<uint8_t>& snapshot, size_t bufferSize)
+    : path(path), bufferSize(bufferSize)
+{
+    ofs.open(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
+        throw std::runtime_error("cannot open " + path);
+
+    TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(TRACE_FILE_MAGIC));
+    header.version = TRACE_FILE_VERSION;
+    header.snapshotSize = snapshot.size();
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size());
+    ofs.flush();
+    if (!ofs.good())
+        throw std::runtime_error("cannot write " + path);
+
+    front.reserve(bufferSize);
+    back.reserve(bufferSize);
+    writer = std::thread(&TraceRecorder::run, this);
+}
+
+
+TraceRecorder::~TraceRecorder()
+{
+    handOff();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    handedOff.notify_one();
+    writer.join();
+}
+
+
+void TraceRecorder::record(const cv::Mat &bboxesDet)
+{
+    assert(bboxesDet.rows == 0 || (bboxesDet.cols == TRACE_NUM_COLS && bboxesDet.type() == CV_32F));
+    if (failed.load(std::memory_order_acquire))
+        throw std::runtime_error("cannot write " + path);
+
+    TraceRecord record;
+    record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch()).count();
+    record.numDets = bboxesDet.rows;
+    record.reserved = 0;
+    append(front, &record, 1);
+    for (int i = 0; i < bboxesDet.rows; ++i)
+        append(front, bboxesDet.ptr<float>(i), TRACE_NUM_COLS);
+    numFrames++;
+
+    if (front.size() >= bufferSize)
+        handOff();
+}
+
+
+void TraceRecorder::flush()
+{
+    handOff();
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [this] { return !pending; });
+    if (failed.load(std::memory_order_acquire))
+        throw std::runtime_error("cannot write " + path);
+}
+
+
+void TraceRecorder::handOff()
+{
+    if (front.empty()) return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (pending)
+        {
+            numStalls++;
+            written.wait(lock, [this] { return !pending; });
+        }
+        std::swap(front, back);
+        pending = true;
+    }
+    handedOff.notify_one();
+}
+
+
+void TraceRecorder::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        handedOff.wait(lock, [this] { return pending || stopping; });
+        if (!pending) break;
+
+        // back belongs to the writer until pending is cleared
+        lock.unlock();
+        ofs.write(reinterpret_cast<const char*>(back.data()), back.size());
+        ofs.flush();
+        bool ok = ofs.good();
+        back.clear();
+        lock.lock();
+
+        if (!ok)
+            failed.store(true, std::memory_order_release);
+        pending = false;
+        written.notify_all();
+    }
+}
+
+
+TraceReader::TraceReader(const std::string& path)
+    : file(path)
+{
+    if (file.size() < sizeof(TraceHeader))
+        throw std::runtime_error("truncated trace " + path);
+
+    header = reinterpret_cast<const TraceHeader*>(file.data());
+    if (memcmp(header->magic, TRACE_FILE_MAGIC, sizeof(TRACE_FILE_MAGIC)) != 0)
+        throw std::runtime_error("not a trace " + path);
+    if (header->version != TRACE_FILE_VERSION)
+        throw std::runtime_error("unsupported trace version " + path);
+
+    size_t offset = sizeof(TraceHeader) + header->snapshotSize;
+    if (offset > file.size())
+        throw std::runtime_error("truncated trace " + path);
+
+    // index the complete records, a partially written tail is ignored
+    TraceRecord record;
+    while (offset + sizeof(record) <= file.size())
+    {
+        memcpy(&record, file.data() + offset, sizeof(record));
+        size_t end = offset + sizeof(record) + size_t(record.numDets) * TRACE_NUM_COLS * sizeof(float);
+        if (end > file.size()) break;
+        offsets.push_back(offset);
+        offset = end;
+    }
+}
+
+
+TraceReader::~TraceReader()
+{
+}
+
+
+std::vector<uint8_t> TraceReader::getSnapshot() const
+{
+    const uint8_t* begin = file.data() + sizeof(TraceHeader);
+    return std::vector<uint8_t>(begin, begin + header->snapshotSize);
+}
+
+
+int64_t TraceReader::getTimestamp(int k) const
+{
+    assert(k >= 0 && k < getNumFrames());
+    TraceRecord record;
+    memcpy(&record, file.data() + offsets[k], sizeof(record));
+    return record.timestamp;
+}
+
+
+cv::Mat TraceReader::getDetections(int k) const
+{
+    assert(k >= 0 && k < getNumFrames());
+    TraceRecord record;
+    memcpy(&record, file.data() + offsets[k], sizeof(record));
+    const uint8_t* dets = file.data() + offsets[k] + sizeof(record);
+    return cv::Mat(record.numDets, TRACE_NUM_COLS, CV_32F, const_cast<uint8_t*>(dets));
+}
@@ -0,0 +1,89 @@
+#include "tracker_pool.h"
+
+using namespace sort;
+
+template<class Model>
+TrackerPoolT<Model>::TrackerPoolT()
+{
+}
+
+
+template<class Model>
+TrackerPoolT<Model>::~TrackerPoolT()
+{
+}
+
+
+template<class Model>
+typename TrackerPoolT<Model>::Tracker::Ptr TrackerPoolT<Model>::acquire(const cv::Mat &bbox, int id)
+{
+    if (freeList.empty())
+        return std::make_shared<Tracker>(bbox, id);
+
+    typename Tracker::Ptr tracker = std::move(freeList.back());
+    freeList.pop_back();
+    tracker->reset(bbox, id);
+    return tracker;
+}
+
+
+template<class Model>
+typename TrackerPoolT<Model>::Tracker::Ptr TrackerPoolT<Model>::acquire(const typename Tracker::State &state)
+{
+    if (freeList.empty())
+        return std::make_shared<Tracker>(state);
+
+    typename Tracker::Ptr tracker = std::move(freeList.back());
+    freeList.pop_back();
+    tracker->importState(state);
+    return tracker;
+}
+
+
+template<class Model>
+void TrackerPoolT<Model>::release(typename Tracker::Ptr tracker)
+{
+    if (tracker != nullptr && freeList.size() < capacity)
+        freeList.push_back(std::move(tracker));
+}
+
+
+template<class Model>
+void TrackerPoolT<Model>::setCapacity(size_t count)
+{
+    capacity = count;
+    if (freeList.size() > capacity)
+    {
+        freeList.resize(capacity);
+        freeList.shrink_to_fit();
+    }
+}
+
+
+template<class Model>
+void TrackerPoolT<Model>::reserve(size_t count)
+{
+    if (freeList.size() >= count) return;
+
+    // one allocation for the trackers and one for the control block they share
+    size_t numMissing = count - freeList.size();
+    std::shared_ptr<Tracker[]> block(new Tracker[numMissing]);
+    freeList.reserve(count);
+    for (size_t i = 0; i < numMissing; ++i)
+        freeList.push_back(typename Tracker::Ptr(block, &block[i]));
+}
+
+
+template<class Model>
+size_t TrackerPoolT<Model>::memoryUsage() const
+{
+    size_t bytes = sizeof(*this) + freeList.capacity() * sizeof(typename Tracker::Ptr);
+    for (const auto& tracker : freeList)
+        bytes += tracker->memoryUsage();
+    return bytes;
+}
+
+
+template class sort::TrackerPoolT<ConstantVelocityModel>;
+template class sort::TrackerPoolT<ReducedVelocityModel>;
+template class sort::TrackerPoolT<ConstantAccelerationModel>;
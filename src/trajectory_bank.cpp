@@ -0,0 +1,99 @@
+#include "trajectory_bank.h"
+#include <assert.h>
+#include <algorithm>
+
+using namespace sort;
+
+TrajectoryBank::TrajectoryBank(size_t capacity)
+    : capacity(capacity)
+{
+    assert(capacity > 0);
+}
+
+
+TrajectoryBank::~TrajectoryBank()
+{
+}
+
+
+void TrajectoryBank::push(int trackerId, int frame, const float* bbox)
+{
+    int slot;
+    auto it = slotOf.find(trackerId);
+    if (it != slotOf.end())
+        slot = it->second;
+    else
+    {
+        if (freeSlots.empty())
+        {
+            // grow the arena by one slot, vector growth keeps this amortized
+            freeSlots.push_back(slots.size());
+            slots.emplace_back();
+            points.resize(slots.size() * capacity);
+        }
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        slots[slot] = Slot();
+        slots[slot].trackerId = trackerId;
+        slotOf[trackerId] = slot;
+    }
+
+    Slot& s = slots[slot];
+    size_t index = (s.head + s.size) % capacity;
+    if (s.size < capacity)
+        s.size++;
+    else
+        s.head = (s.head + 1) % capacity;
+    points[slot * capacity + index] = {frame, bbox[0], bbox[1], bbox[2], bbox[3]};
+}
+
+
+void TrajectoryBank::remove(int trackerId)
+{
+    auto it = slotOf.find(trackerId);
+    if (it == slotOf.end()) return;
+    slots[it->second].trackerId = -1;
+    freeSlots.push_back(it->second);
+    slotOf.erase(it);
+}
+
+
+TrajectoryView TrajectoryBank::get(int trackerId) const
+{
+    auto it = slotOf.find(trackerId);
+    return it == slotOf.end() ? TrajectoryView() : makeView(it->second);
+}
+
+
+std::vector<TrajectoryView> TrajectoryBank::getAll() const
+{
+    std::vector<TrajectoryView> views;
+    views.reserve(slotOf.size());
+    for (int slot = 0; slot < (int)slots.size(); ++slot)
+        if (slots[slot].trackerId >= 0)
+            views.push_back(makeView(slot));
+    return views;
+}
+
+
+size_t TrajectoryBank::memoryUsage() const
+{
+    // an unordered_map node holds the pair and the next pointer, plus one bucket pointer per bucket
+    return sizeof(*this) + points.capacity() * sizeof(TrajectoryPoint) + slots.capacity() * sizeof(Slot) +
+           freeSlots.capacity() * sizeof(int) + slotOf.size() * (sizeof(std::pair<const int, int>) + sizeof(void*)) +
+           slotOf.bucket_count() * sizeof(void*);
+}
+
+
+TrajectoryView TrajectoryBank::makeView(int slot) const
+{
+    const Slot& s = slots[slot];
+    const TrajectoryPoint* base = points.data() + slot * capacity;
+
+    TrajectoryView view;
+    view.trackerId = s.trackerId;
+    size_t firstSize = std::min<size_t>(s.size, capacity - s.head);
+    view.first = {base + s.head, firstSize};
+    view.second = {base, s.size - firstSize};
+    return view;
+}
@@ -0,0 +1,33 @@
+#include <iostream>
+#include <cstdlib>
+#include "reference_check.h"
+
+using std::cout;
+using std::endl;
+
+// drift of the unrolled filter of a model against cv::KalmanFilter, within the tolerance of ReferenceCheck
+template<class Model>
+bool check(const char* name, int numFrames, unsigned seed)
+{
+    float drift = sort::ReferenceCheck::motionModelDrift<Model>(numFrames, seed);
+    bool isOk = drift <= sort::ReferenceCheck::DEFAULT_TOLERANCE;
+    cout << name << ": drift " << drift << (isOk ? " ok" : " above the tolerance") << endl;
+    return isOk;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 3) {
+        cout << "usage: ./check_models [frames] [seed]" << endl;
+        return -1;
+    }
+    int numFrames = argc > 1 ? std::atoi(argv[1]) : 1000;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    cout << "unrolled Kalman filter against cv::KalmanFilter, " << numFrames << " frames, tolerance "
+         << sort::ReferenceCheck::DEFAULT_TOLERANCE << endl;
+    bool isOk = check<sort::ConstantVelocityModel>("constant velocity", numFrames, seed);
+    isOk &= check<sort::ReducedVelocityModel>("reduced velocity", numFrames, seed);
+    isOk &= check<sort::ConstantAccelerationModel>("constant acceleration", numFrames, seed);
+    return isOk ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <filesystem>
+#include <stdexcept>
+#include "det_file.h"
+
+namespace fs = std::filesystem;
+
+using std::cout;
+using std::endl;
+using std::string;
+
+void convert(const string& src, const string& dst) {
+    sort::DetSequence seq = sort::readMotText(src);
+    sort::writeDetFile(dst, seq);
+
+    size_t numDets = 0;
+    for (const auto& dets : seq.dets) numDets += dets.rows;
+    cout << src << " -> " << dst << " (" << seq.dets.size() << " frames, " << numDets << " boxes)" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 && argc != 3) {
+        cout << "usage: ./convert_dets [data folder]            converts det/det.txt and gt/gt.txt" << endl;
+        cout << "       ./convert_dets [input txt] [output file]" << endl;
+        return -1;
+    }
+
+    try {
+        if (argc == 3) {
+            convert(argv[1], argv[2]);
+            return 0;
+        }
+
+        fs::path dataFolder(argv[1]);
+        int converted = 0;
+        for (string name : {"det/det", "gt/gt"}) {
+            fs::path src = dataFolder / (name + ".txt");
+            if (!fs::exists(src)) continue;
+            convert(src, dataFolder / (name + ".sortdet"));
+            converted++;
+        }
+        if (converted == 0) {
+            cout << "nothing to convert in " << dataFolder << endl;
+            return -1;
+        }
+    } catch (const std::exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include "sort.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+struct ReplayResult
+{
+    vector<double> latencies;   // microseconds per frame
+    uint64_t hash = 1469598103934665603ull;     // FNV-1a of every output
+};
+
+ReplayResult replay(const sort::TraceReader& reader, int numThreads, std::ofstream* ofs)
+{
+    // same ids as recorded: restore() moves the restarted sequence to the recorded filterCount
+    vector<uint8_t> snapshot = reader.getSnapshot();
+    sort::TrackerIds::resetFilterIds();
+    sort::Sort mot;
+    mot.restore(snapshot);
+    if (numThreads > 1) mot.setNumThreads(numThreads);
+
+    sort::SortSnapshotHeader header;
+    memcpy(&header, snapshot.data(), sizeof(header));
+    int firstFrame = header.frameCount + 1;
+
+    ReplayResult result;
+    for (int k = 0; k < reader.getNumFrames(); ++k) {
+        cv::Mat dets = reader.getDetections(k);
+        auto t0 = std::chrono::steady_clock::now();
+        cv::Mat tracks = mot.update(dets);
+        auto t1 = std::chrono::steady_clock::now();
+        result.latencies.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+
+        const uint8_t* bytes = tracks.ptr<uint8_t>();
+        for (size_t b = 0; b < tracks.total() * tracks.elemSize(); ++b)
+            result.hash = (result.hash ^ bytes[b]) * 1099511628211ull;
+
+        if (ofs == nullptr) continue;
+        // MOT format, [frame, id, x0, y0, w, h, score, -1, -1, -1]
+        for (int i = 0; i < tracks.rows; ++i) {
+            const float* t = tracks.ptr<float>(i);
+            *ofs << firstFrame + k << "," << int(t[8]) << "," << t[0] - t[2] / 2 << "," << t[1] - t[3] / 2
+                 << "," << t[2] << "," << t[3] << "," << t[4] << ",-1,-1,-1" << endl;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int numThreads = 1, repeat = 1, top = 10;
+    string tracePath, outputPath;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) numThreads = std::stoi(argv[++i]);
+        else if (arg == "--repeat" && hasValue) repeat = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--top" && hasValue) top = std::stoi(argv[++i]);
+        else if (arg == "--output" && hasValue) outputPath = argv[++i];
+        else tracePath = arg;
+    }
+
+    if (tracePath.empty()) {
+        cout << "usage: ./replay_trace [options] [trace], e.g. ./replay_trace tracking.sorttrace" << endl;
+        cout << "options: --threads N  --repeat N  --top N  --output tracks.txt" << endl;
+        return -1;
+    }
+
+    try {
+        sort::TraceReader reader(tracePath);
+        int numFrames = reader.getNumFrames();
+        cout << tracePath << ": " << numFrames << " frames" << endl;
+        if (numFrames == 0) return 0;
+
+        std::ofstream ofs;
+        if (!outputPath.empty()) {
+            ofs.open(outputPath);
+            if (!ofs.is_open()) throw std::runtime_error("cannot open " + outputPath);
+        }
+
+        // every repeat must give the same output, the slowest run of every frame is kept
+        ReplayResult first = replay(reader, numThreads, ofs.is_open() ? &ofs : nullptr);
+        vector<double> latencies = first.latencies;
+        bool deterministic = true;
+        for (int r = 1; r < repeat; ++r) {
+            ReplayResult result = replay(reader, numThreads, nullptr);
+            deterministic = deterministic && result.hash == first.hash;
+            for (int k = 0; k < numFrames; ++k)
+                latencies[k] = std::max(latencies[k], result.latencies[k]);
+        }
+
+        vector<double> sorted = latencies;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&](double p) { return sorted[std::min<size_t>(sorted.size() - 1, p * sorted.size())]; };
+        cout << std::fixed << std::setprecision(1);
+        cout << "update latency (us): mean " << std::accumulate(sorted.begin(), sorted.end(), 0.0) / numFrames
+             << "  p50 " << percentile(0.5) << "  p99 " << percentile(0.99) << "  max " << sorted.back() << endl;
+        if (repeat > 1)
+            cout << "output " << (deterministic ? "identical" : "DIFFERS") << " across " << repeat << " runs" << endl;
+
+        // slowest frames, with the recorded gap to the previous frame
+        vector<int> order(numFrames);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return latencies[a] > latencies[b]; });
+        cout << " record  latency(us)  dets  gap(ms)" << endl;
+        for (int i = 0; i < std::min(top, numFrames); ++i) {
+            int k = order[i];
+            double gap = k > 0 ? (reader.getTimestamp(k) - reader.getTimestamp(k - 1)) * 1e-6 : 0.0;
+            cout << std::setw(7) << k << std::setw(13) << latencies[k]
+                 << std::setw(6) << reader.getDetections(k).rows << std::setw(9) << gap << endl;
+        }
+        return deterministic ? 0 : 1;
+    } catch (const std::exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <csignal>
+#include "shm_transport.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+volatile std::sig_atomic_t stopped = 0;
+
+void onSignal(int) {
+    stopped = 1;
+}
+
+int main(int argc, char** argv)
+{
+    int numChannels = 16, numSlots = 4, maxDets = 256, maxAge = 1, minHits = 3;
+    float iouThresh = 0.3f;
+    string name;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--channels" && hasValue) numChannels = std::stoi(argv[++i]);
+        else if (arg == "--slots" && hasValue) numSlots = std::stoi(argv[++i]);
+        else if (arg == "--max-dets" && hasValue) maxDets = std::stoi(argv[++i]);
+        else if (arg == "--max-age" && hasValue) maxAge = std::stoi(argv[++i]);
+        else if (arg == "--min-hits" && hasValue) minHits = std::stoi(argv[++i]);
+        else if (arg == "--iou" && hasValue) iouThresh = std::stof(argv[++i]);
+        else name = arg;
+    }
+
+    if (name.empty() || name[0] != '/' || numChannels <= 0 || numSlots <= 0 || maxDets <= 0) {
+        cout << "usage: ./sort_server [options] [shm name], e.g. ./sort_server --channels 32 /sort" << endl;
+        cout << "options: --channels N  --slots N  --max-dets N  --max-age N  --min-hits N  --iou X" << endl;
+        return -1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    try {
+        sort::ShmServer server(name, numChannels, numSlots, maxDets, maxAge, minHits, iouThresh);
+        cout << "serving " << numChannels << " channels on " << name << endl;
+
+        // one line of throughput per second while busy
+        auto last = std::chrono::steady_clock::now();
+        long lastFrames = 0;
+        while (!stopped) {
+            server.serve(std::chrono::milliseconds(200));
+            auto now = std::chrono::steady_clock::now();
+            if (now - last >= std::chrono::seconds(1)) {
+                long frames = server.getNumFrames();
+                if (frames != lastFrames)
+                    cout << std::fixed << std::setprecision(0)
+                         << (frames - lastFrames) / std::chrono::duration<double>(now - last).count()
+                         << " frames/s, " << frames << " total" << endl;
+                last = now;
+                lastFrames = frames;
+            }
+        }
+    } catch (const std::exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include "param_sweep.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+using sort::SortParams;
+using sort::SequenceData;
+using sort::SweepResult;
+
+template<typename _Tp>
+vector<_Tp> parseList(const string& s) {
+    vector<_Tp> ret;
+    std::istringstream iss(s);
+    string item;
+    while (getline(iss, item, ','))
+        ret.push_back(std::stod(item));
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    vector<int> maxAges = {1, 2, 3, 5};
+    vector<int> minHits = {1, 2, 3, 5};
+    vector<float> iouThreshs = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f};
+    int numThreads = 0, top = 10;
+    vector<string> dataFolders;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max-age" && hasValue) maxAges = parseList<int>(argv[++i]);
+        else if (arg == "--min-hits" && hasValue) minHits = parseList<int>(argv[++i]);
+        else if (arg == "--iou" && hasValue) iouThreshs = parseList<float>(argv[++i]);
+        else if (arg == "--threads" && hasValue) numThreads = std::stoi(argv[++i]);
+        else if (arg == "--top" && hasValue) top = std::stoi(argv[++i]);
+        else dataFolders.push_back(arg);
+    }
+
+    if (dataFolders.empty()) {
+        cout << "usage: ./sweep_sort [options] [data folder]..., e.g. ./sweep_sort ../data/TUD-Campus ../data/TUD-Stadtmitte" << endl;
+        cout << "options: --max-age 1,2,3  --min-hits 1,3  --iou 0.1,0.3,0.5  --threads N  --top N" << endl;
+        return -1;
+    }
+
+    // load every sequence once, the jobs share them read-only
+    vector<SequenceData> seqs;
+    for (const string& folder : dataFolders)
+        seqs.push_back(sort::loadSequence(folder));
+
+    vector<SortParams> grid;
+    for (int maxAge : maxAges)
+        for (int hits : minHits)
+            for (float iouThresh : iouThreshs)
+                grid.push_back({maxAge, hits, iouThresh});
+
+    auto t0 = std::chrono::steady_clock::now();
+    vector<SweepResult> results = sort::sweep(grid, seqs, numThreads);
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b) {
+        return a.metrics.mota() > b.metrics.mota();
+    });
+
+    cout << grid.size() << " parameter sets x " << seqs.size() << " sequences in "
+         << std::chrono::duration<double>(t1 - t0).count() << " s" << endl;
+    cout << "maxAge minHits iouThresh     MOTA     IDF1   IDsw   Frag     FP     FN" << endl;
+    cout << std::fixed;
+    for (int i = 0; i < std::min<int>(top, results.size()); ++i) {
+        const SweepResult& r = results[i];
+        cout << std::setw(6) << r.params.maxAge << std::setw(8) << r.params.minHits
+             << std::setw(10) << std::setprecision(2) << r.params.iouThresh
+             << std::setw(9) << std::setprecision(4) << r.metrics.mota()
+             << std::setw(9) << r.metrics.idf1()
+             << std::setw(7) << r.metrics.idsw << std::setw(7) << r.metrics.frag
+             << std::setw(7) << r.metrics.fp << std::setw(7) << r.metrics.fn << endl;
+    }
+
+    return 0;
+}